@@ -0,0 +1,62 @@
+#include "Chroma.hpp"
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace av {
+	Chroma::Chroma(std::span<long double const> frequencies, size_t bins_per_octave, size_t num_classes)
+		: num_classes{num_classes}
+		, bins_per_octave{bins_per_octave}
+		, folded(bins_per_octave)
+		, chroma(num_classes) {
+		if (!bins_per_octave || !num_classes)
+			throw std::invalid_argument("bins_per_octave and num_classes must be positive");
+		for (size_t i = bins_per_octave; i < frequencies.size(); ++i)
+			if (std::abs(frequencies[i] / frequencies[i - bins_per_octave] - 2.0l) > 1e-9l)
+				throw std::invalid_argument("chroma needs exactly bins_per_octave log-spaced bins per octave");
+		long double const c = 440.0l * std::exp2(-9.0l / 12.0l);
+		for (size_t j = 0; j < std::min(bins_per_octave, frequencies.size()); ++j) {
+			long double position = std::log2(frequencies[j] / c) * static_cast<long double>(num_classes);
+			position -= std::floor(position / num_classes) * num_classes; // [0, num_classes)
+			auto lo = static_cast<size_t>(std::floor(position));
+			auto fraction = static_cast<float>(position - lo);
+			entries.push_back({static_cast<uint32_t>(j), static_cast<uint32_t>(lo % num_classes), 1.0f - fraction});
+			if (fraction > 1e-6f)
+				entries.push_back({static_cast<uint32_t>(j), static_cast<uint32_t>((lo + 1) % num_classes), fraction});
+		}
+	}
+
+	std::span<float const> Chroma::compute(std::span<float const> magnitudes) {
+		AV_TRACE_SCOPE("chroma");
+		std::ranges::fill(folded, 0.0f);
+		float const *m = magnitudes.data();
+		size_t const n = magnitudes.size();
+		size_t octave = 0;
+		for (; octave + bins_per_octave <= n; octave += bins_per_octave) {
+			size_t j = 0;
+#if defined(__SSE2__)
+			for (; j + 4 <= bins_per_octave; j += 4)
+				_mm_storeu_ps(folded.data() + j, _mm_add_ps(_mm_loadu_ps(folded.data() + j), _mm_loadu_ps(m + octave + j)));
+#endif
+			for (; j < bins_per_octave; ++j)
+				folded[j] += m[octave + j];
+		}
+		for (size_t j = 0; octave + j < n; ++j) // partial top octave
+			folded[j] += m[octave + j];
+
+		std::ranges::fill(chroma, 0.0f);
+		for (Entry const &entry : entries)
+			chroma[entry.pitch_class] += entry.weight * folded[entry.folded_bin];
+		float max = *std::ranges::max_element(chroma);
+		if (max > 0.0f)
+			for (float &value : chroma) value /= max;
+		return chroma;
+	}
+} // av
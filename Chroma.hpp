@@ -0,0 +1,38 @@
+#ifndef AUDIO_VISUALIZER_CHROMA_HPP
+#define AUDIO_VISUALIZER_CHROMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace av {
+	// pitch class profile of a log-spaced spectrum, class 0 is C
+	// the magnitudes are first folded onto one octave (bins an octave apart line up exactly, so that is a
+	// vertical sum of contiguous rows) and the folded octave is then spread onto the classes with a precomputed
+	// sparse mapping, each folded bin splitting itself between the two nearest classes
+	class Chroma {
+	public:
+		// frequencies have to be ascending with exactly bins_per_octave bins per octave, like generate_frequencies in main
+		Chroma(std::span<long double const> frequencies, size_t bins_per_octave, size_t num_classes);
+
+		// normalized so the strongest class is 1, the span stays valid until the next call
+		std::span<float const> compute(std::span<float const> magnitudes);
+
+		size_t const num_classes;
+
+	private:
+		struct Entry {
+			uint32_t folded_bin;
+			uint32_t pitch_class;
+			float weight;
+		};
+
+		size_t const bins_per_octave;
+		std::vector<Entry> entries;
+		std::vector<float> folded;
+		std::vector<float> chroma;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_CHROMA_HPP
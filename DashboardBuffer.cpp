@@ -0,0 +1,209 @@
+#include "DashboardBuffer.hpp"
+
+#include "constants.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace av {
+	std::array<vk::PushConstantRange, 1> const DashboardBuffer::push_constant_ranges{
+		vk::PushConstantRange{
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.offset = 0,
+			.size = sizeof(PushConstants),
+		},
+	};
+
+	void DashboardBuffer::bind_and_draw(
+		vk::raii::CommandBuffer const &command_buffer,
+		vk::raii::PipelineLayout const &pipeline_layout
+	) const {
+		command_buffer.bindVertexBuffers(0, {*_upload_buffer.buffer}, {0});
+		command_buffer.bindDescriptorSets(
+			vk::PipelineBindPoint::eGraphics, *pipeline_layout, 0, {*_descriptor_set}, nullptr);
+		command_buffer.pushConstants<PushConstants>(
+			*pipeline_layout, vk::ShaderStageFlagBits::eVertex, 0, _push_constants);
+		command_buffer.draw(NUM_BAR_VERTICES * _push_constants.num_bars, _num_channels, 0, 0);
+	}
+
+	void DashboardBuffer::commit_magnitudes() {
+		_slots.commit();
+		_magnitude_data = _upload_buffer.data.subspan(_magnitudes_offset + _slots.write() * _slot_size, _slot_size);
+		set_slot_offsets();
+	}
+
+	void DashboardBuffer::mark_drawn(uint64_t frame_value) {
+		_slots.mark_drawn(frame_value);
+	}
+
+	uint64_t DashboardBuffer::write_frame_value() const {
+		return _slots.write_frame_value();
+	}
+
+	void DashboardBuffer::set_blend(float blend) {
+		_push_constants.blend = blend;
+	}
+
+	DashboardBuffer::DashboardBuffer(
+		DashboardLayout const &layout,
+		Gpu const &gpu,
+		vma::Allocator const &allocator,
+		UploadStrategy upload_strategy
+	)
+		: magnitude_format{layout.magnitude_format}
+		, _num_channels{layout.num_channels}
+		, _push_constants{
+			.num_bars = layout.num_bars,
+			.bars_per_octave = layout.bars_per_octave,
+			.newest_offset = 0, // see set_slot_offsets
+			.previous_offset = 0,
+			.blend = 1.0f,
+		}
+		, _binding_descriptions{
+			vk::VertexInputBindingDescription{
+				.binding = 0,
+				.stride = sizeof(Viewport),
+				.inputRate = vk::VertexInputRate::eInstance,
+			},
+		}
+		, _attribute_descriptions{
+			vk::VertexInputAttributeDescription{
+				.location = 0,
+				.binding = 0,
+				.format = vk::Format::eR32G32B32A32Sfloat,
+				.offset = 0,
+			},
+		}
+		, _magnitudes_offset{
+			(layout.num_channels * sizeof(Viewport) + TEXEL_BUFFER_ALIGNMENT - 1) / TEXEL_BUFFER_ALIGNMENT
+			* TEXEL_BUFFER_ALIGNMENT}
+		, _slot_size{get_slot_size(layout, gpu)}
+		, _upload_buffer{
+			gpu, allocator, _magnitudes_offset + MagnitudeSlots::NUM_SLOTS * _slot_size,
+			vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eUniformTexelBuffer,
+			_magnitudes_offset, MagnitudeSlots::NUM_SLOTS * _slot_size,
+			upload_strategy
+		}
+		, _magnitude_data{_upload_buffer.data.subspan(_magnitudes_offset, _slot_size)}
+		, _buffer_view{create_buffer_view(
+			gpu, _upload_buffer, layout.magnitude_format, _magnitudes_offset, MagnitudeSlots::NUM_SLOTS * _slot_size)}
+		, _descriptor_set_layout{create_descriptor_set_layout(gpu)}
+		, _set_layouts{*_descriptor_set_layout}
+		, _pipeline_description{
+			.vertex_shader_file_name = constants::DASHBOARD_VERTEX_SHADER_FILE_NAME,
+			.fragment_shader_file_name = constants::FRAGMENT_SHADER_FILE_NAME,
+			.binding_descriptions = _binding_descriptions,
+			.attribute_descriptions = _attribute_descriptions,
+			.topology = vk::PrimitiveTopology::eTriangleList,
+			.push_constant_ranges = push_constant_ranges,
+			.set_layouts = _set_layouts,
+		}
+		, _descriptor_pool{create_descriptor_pool(gpu)}
+		, _descriptor_set{create_descriptor_set(gpu, _descriptor_pool, _descriptor_set_layout, _buffer_view)} {
+		// row-major grid, first channel in the top left
+		uint32_t const columns = layout.columns
+		                         ? layout.columns
+		                         : static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(layout.num_channels))));
+		uint32_t const rows = (layout.num_channels + columns - 1) / columns;
+		float const cell_width = 2.0f / static_cast<float>(columns);
+		float const cell_height = 2.0f / static_cast<float>(rows);
+		auto *viewports = reinterpret_cast<Viewport *>(_upload_buffer.data.data());
+		for (uint32_t channel = 0; channel < layout.num_channels; ++channel)
+			viewports[channel] = Viewport{
+				.x = -1.0f + (static_cast<float>(channel % columns) + CELL_MARGIN) * cell_width,
+				.y = -1.0f + (static_cast<float>(channel / columns) + CELL_MARGIN) * cell_height,
+				.width = (1.0f - 2.0f * CELL_MARGIN) * cell_width,
+				.height = (1.0f - 2.0f * CELL_MARGIN) * cell_height,
+			};
+		std::ranges::fill(_upload_buffer.data.subspan(_magnitudes_offset), std::byte{0}); // encodes 0 in every format
+		set_slot_offsets();
+	}
+
+	void DashboardBuffer::set_slot_offsets() {
+		uint32_t const slot_magnitudes = _num_channels * _push_constants.num_bars;
+		_push_constants.newest_offset = _slots.newest() * slot_magnitudes;
+		_push_constants.previous_offset = _slots.previous() * slot_magnitudes;
+	}
+
+	// every slot has to fit in one texel buffer
+	size_t DashboardBuffer::get_slot_size(DashboardLayout const &layout, Gpu const &gpu) {
+		if (!layout.num_channels || !layout.num_bars)
+			throw std::invalid_argument("a dashboard needs at least one channel and one bar");
+		size_t const num_magnitudes = static_cast<size_t>(layout.num_channels) * layout.num_bars;
+		if (MagnitudeSlots::NUM_SLOTS * num_magnitudes > gpu.physical_device.getProperties().limits.maxTexelBufferElements)
+			throw std::invalid_argument("too many channels and bars for one texel buffer");
+		return num_magnitudes * magnitude_size(layout.magnitude_format);
+	}
+
+	vk::raii::BufferView DashboardBuffer::create_buffer_view(
+		Gpu const &gpu,
+		UploadBuffer const &upload_buffer,
+		MagnitudeFormat magnitude_format,
+		vk::DeviceSize offset,
+		vk::DeviceSize size
+	) {
+		vk::BufferViewCreateInfo buffer_view_create_info{
+			.buffer = *upload_buffer.buffer,
+			.format = magnitude_vk_format(magnitude_format), // the shader sees decoded floats in every format
+			.offset = offset,
+			.range = size,
+		};
+		return {gpu.device, buffer_view_create_info};
+	}
+
+	vk::raii::DescriptorSetLayout DashboardBuffer::create_descriptor_set_layout(Gpu const &gpu) {
+		vk::DescriptorSetLayoutBinding descriptor_set_layout_binding{
+			.binding = 0,
+			.descriptorType = vk::DescriptorType::eUniformTexelBuffer,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+		};
+		vk::DescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{
+			.bindingCount = 1,
+			.pBindings = &descriptor_set_layout_binding,
+		};
+		return {gpu.device, descriptor_set_layout_create_info};
+	}
+
+	vk::raii::DescriptorPool DashboardBuffer::create_descriptor_pool(Gpu const &gpu) {
+		vk::DescriptorPoolSize descriptor_pool_size{
+			.type = vk::DescriptorType::eUniformTexelBuffer,
+			.descriptorCount = 1,
+		};
+		vk::DescriptorPoolCreateInfo descriptor_pool_create_info{
+			// vk::raii::DescriptorSet frees itself
+			.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+			.maxSets = 1,
+			.poolSizeCount = 1,
+			.pPoolSizes = &descriptor_pool_size,
+		};
+		return {gpu.device, descriptor_pool_create_info};
+	}
+
+	vk::raii::DescriptorSet DashboardBuffer::create_descriptor_set(
+		Gpu const &gpu,
+		vk::raii::DescriptorPool const &descriptor_pool,
+		vk::raii::DescriptorSetLayout const &descriptor_set_layout,
+		vk::raii::BufferView const &buffer_view
+	) {
+		vk::DescriptorSetAllocateInfo descriptor_set_allocate_info{
+			.descriptorPool = *descriptor_pool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &*descriptor_set_layout,
+		};
+		vk::raii::DescriptorSet descriptor_set{
+			std::move(vk::raii::DescriptorSets{gpu.device, descriptor_set_allocate_info}.front())};
+		vk::WriteDescriptorSet write_descriptor_set{
+			.dstSet = *descriptor_set,
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eUniformTexelBuffer,
+			.pTexelBufferView = &*buffer_view,
+		};
+		gpu.device.updateDescriptorSets(write_descriptor_set, nullptr);
+		return descriptor_set;
+	}
+} // av
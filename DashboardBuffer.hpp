@@ -0,0 +1,104 @@
+#ifndef AUDIO_VISUALIZER_DASHBOARDBUFFER_HPP
+#define AUDIO_VISUALIZER_DASHBOARDBUFFER_HPP
+
+#include "Gpu.hpp"
+#include "Layout.hpp"
+#include "MagnitudeEncoding.hpp"
+#include "MagnitudeSlots.hpp"
+#include "PipelineDescription.hpp"
+#include "UploadBuffer.hpp"
+#include "graphics_headers.hpp"
+#include <array>
+#include <span>
+
+namespace av {
+	// many bar spectra in a grid, all drawn by a single draw call
+	// one instance per channel, placed by a per-instance viewport, with six vertices per bar
+	// the vertex shader fetches each bar's magnitude from a texel buffer of every channel's magnitudes,
+	// so the cpu and driver work doesn't grow with the number of channels
+	// like InstanceBuffer, the two newest analysis frames are blended, out of a ring of MagnitudeSlots
+	class DashboardBuffer {
+	public:
+		DashboardBuffer(
+			DashboardLayout const &,
+			Gpu const &,
+			vma::Allocator const &,
+			UploadStrategy
+		);
+		void bind_and_draw(vk::raii::CommandBuffer const &, vk::raii::PipelineLayout const &) const;
+		// after writing a frame into magnitude_data, it becomes the newest and magnitude_data moves to the next slot
+		// wait for write_frame_value on the FrameTimeline before writing into it
+		void commit_magnitudes();
+		// frame_value is signaled once the frame just recorded is done reading the slots
+		void mark_drawn(uint64_t frame_value);
+		[[nodiscard]] uint64_t write_frame_value() const;
+		// 0 draws the previous frame, 1 the newest
+		void set_blend(float);
+		// num_bars encoded magnitudes per channel, channel after channel, see encode_magnitudes
+		// only valid until the next commit_magnitudes
+		std::span<std::byte> const &magnitude_data{_magnitude_data};
+		// only the magnitudes are uploaded every frame
+		UploadBuffer const &upload_buffer{_upload_buffer};
+		MagnitudeFormat const magnitude_format;
+		PipelineDescription const &pipeline_description{_pipeline_description};
+
+		struct PushConstants {
+			uint32_t num_bars;
+			uint32_t bars_per_octave;
+			uint32_t newest_offset; // in magnitudes, from the start of the texel buffer
+			uint32_t previous_offset;
+			float blend;
+		};
+
+		// a grid cell in normalized device coordinates, one per channel
+		struct Viewport {
+			float x;
+			float y;
+			float width;
+			float height;
+		};
+
+	private:
+		static constexpr uint32_t NUM_BAR_VERTICES = 6; // two triangles
+		// the highest minTexelBufferOffsetAlignment allowed, the magnitudes start at a multiple of it
+		static constexpr vk::DeviceSize TEXEL_BUFFER_ALIGNMENT = 256;
+		static constexpr float CELL_MARGIN = 0.02f; // of each cell on every side, so neighbouring channels don't touch
+		uint32_t const _num_channels;
+		PushConstants _push_constants;
+		std::array<vk::VertexInputBindingDescription, 1> const _binding_descriptions;
+		std::array<vk::VertexInputAttributeDescription, 1> const _attribute_descriptions;
+		vk::DeviceSize const _magnitudes_offset; // after the viewports
+		size_t const _slot_size; // one frame of encoded magnitudes for every channel
+		UploadBuffer const _upload_buffer;
+		MagnitudeSlots _slots;
+		std::span<std::byte> _magnitude_data;
+		vk::raii::BufferView const _buffer_view;
+		vk::raii::DescriptorSetLayout const _descriptor_set_layout;
+		std::array<vk::DescriptorSetLayout, 1> const _set_layouts;
+		PipelineDescription const _pipeline_description; // after everything it points into
+		vk::raii::DescriptorPool const _descriptor_pool;
+		vk::raii::DescriptorSet const _descriptor_set;
+
+		void set_slot_offsets();
+		static size_t get_slot_size(DashboardLayout const &, Gpu const &);
+		static vk::raii::BufferView create_buffer_view(
+			Gpu const &,
+			UploadBuffer const &,
+			MagnitudeFormat,
+			vk::DeviceSize offset,
+			vk::DeviceSize size
+		);
+		static vk::raii::DescriptorSetLayout create_descriptor_set_layout(Gpu const &);
+		static vk::raii::DescriptorPool create_descriptor_pool(Gpu const &);
+		static vk::raii::DescriptorSet create_descriptor_set(
+			Gpu const &,
+			vk::raii::DescriptorPool const &,
+			vk::raii::DescriptorSetLayout const &,
+			vk::raii::BufferView const &
+		);
+
+		static std::array<vk::PushConstantRange, 1> const push_constant_ranges;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_DASHBOARDBUFFER_HPP
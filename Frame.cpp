@@ -6,24 +6,44 @@
 namespace av {
 	Frame::Frame(
 		vk::raii::CommandBuffer &&command_buffer,
-		GraphicsDevice const &gpu
+		vk::raii::CommandBuffer &&transfer_command_buffer,
+		Gpu const &gpu
 	)
 		: _command_buffer{std::move(command_buffer)}
+		, _transfer_command_buffer{std::move(transfer_command_buffer)}
 		, _draw_complete{gpu.device, vk::SemaphoreCreateInfo{}}
 		, _present_complete{gpu.device, vk::SemaphoreCreateInfo{}}
-		, _in_flight{gpu.device, {.flags = vk::FenceCreateFlagBits::eSignaled}} {}
+		, _timestamp_query_pool{create_timestamp_query_pool(gpu)} {}
+
+	vk::raii::QueryPool Frame::create_timestamp_query_pool(Gpu const &gpu) {
+		if (!gpu.timestamp_valid_bits) return nullptr;
+		vk::QueryPoolCreateInfo query_pool_create_info{
+			.queryType = vk::QueryType::eTimestamp,
+			.queryCount = 2,
+		};
+		return {gpu.device, query_pool_create_info};
+	}
 
 	Frames::Frames(
 		size_t num_frames,
-		const GraphicsDevice &gpu
+		Gpu const &gpu
 	) {
 		reserve(num_frames);
 		vk::CommandBufferAllocateInfo command_buffer_allocate_info{
 			.commandPool = *gpu.graphics_command_pool,
 			.level = vk::CommandBufferLevel::ePrimary,
-			.commandBufferCount = num_frames,
+			.commandBufferCount = static_cast<uint32_t>(num_frames),
 		};
-		for (auto &&command_buffer : vk::raii::CommandBuffers(gpu.device, command_buffer_allocate_info))
-			emplace_back(std::move(command_buffer), gpu);
+		vk::raii::CommandBuffers command_buffers{gpu.device, command_buffer_allocate_info};
+		vk::raii::CommandBuffers transfer_command_buffers{nullptr};
+		if (*gpu.transfer_command_pool) {
+			command_buffer_allocate_info.commandPool = *gpu.transfer_command_pool;
+			transfer_command_buffers = vk::raii::CommandBuffers{gpu.device, command_buffer_allocate_info};
+		}
+		for (size_t i = 0; i < num_frames; ++i)
+			emplace_back(
+				std::move(command_buffers[i]),
+				transfer_command_buffers.empty() ? vk::raii::CommandBuffer{nullptr} : std::move(transfer_command_buffers[i]),
+				gpu);
 	}
 } // av
@@ -10,25 +10,35 @@ namespace av {
 	public:
 		Frame(
 			vk::raii::CommandBuffer &&,
+			vk::raii::CommandBuffer &&transfer_command_buffer,
 			Gpu const &
 		);
 		vk::raii::CommandBuffer const &command_buffer{_command_buffer};
+		// null without a dedicated transfer queue
+		vk::raii::CommandBuffer const &transfer_command_buffer{_transfer_command_buffer};
+		// binary, the swapchain can't use timeline semaphores
 		vk::raii::Semaphore const &draw_complete{_draw_complete};
 		vk::raii::Semaphore const &present_complete{_present_complete};
-		vk::raii::Fence const &in_flight{_in_flight};
+		uint64_t timeline_value = 0; // the FrameTimeline value signaled once the gpu is done with this frame
+		// two timestamps, written before and after the render pass
+		// null if the graphics queue does not support timestamps
+		vk::raii::QueryPool const &timestamp_query_pool{_timestamp_query_pool};
+		bool timestamps_pending = false; // true if the command buffer wrote timestamps that have not been read yet
 	private:
 		// todo read this https://www.khronos.org/blog/understanding-vulkan-synchronization
-		// todo and this (vulkan 1.2+, not good for mobile) https://www.khronos.org/blog/vulkan-timeline-semaphores
 		vk::raii::CommandBuffer _command_buffer;
+		vk::raii::CommandBuffer _transfer_command_buffer;
 		vk::raii::Semaphore _draw_complete;
 		vk::raii::Semaphore _present_complete;
-		vk::raii::Fence _in_flight;
+		vk::raii::QueryPool _timestamp_query_pool;
+		static vk::raii::QueryPool create_timestamp_query_pool(Gpu const &);
 	};
 
 	class Frames : std::vector<Frame> {
 	public:
-		Frames(size_t num_frames, GraphicsDevice const &);
+		Frames(size_t num_frames, Gpu const &);
 		using std::vector<Frame>::operator[];
+		using std::vector<Frame>::size;
 	};
 } // av
 
@@ -0,0 +1,28 @@
+#include "FrameTimeline.hpp"
+
+namespace av {
+	FrameTimeline::FrameTimeline(Gpu const &gpu)
+		: device{gpu.device}
+		, _semaphore{create_semaphore(gpu)} {}
+
+	uint64_t FrameTimeline::completed_value() const {
+		return _semaphore.getCounterValue();
+	}
+
+	bool FrameTimeline::wait(uint64_t value, uint64_t timeout_nanoseconds) const {
+		vk::SemaphoreWaitInfo semaphore_wait_info{
+			.semaphoreCount = 1,
+			.pSemaphores = &*_semaphore,
+			.pValues = &value,
+		};
+		return device.waitSemaphores(semaphore_wait_info, timeout_nanoseconds) == vk::Result::eSuccess;
+	}
+
+	vk::raii::Semaphore FrameTimeline::create_semaphore(Gpu const &gpu) {
+		vk::SemaphoreTypeCreateInfo semaphore_type_create_info{
+			.semaphoreType = vk::SemaphoreType::eTimeline,
+			.initialValue = 0,
+		};
+		return {gpu.device, vk::SemaphoreCreateInfo{.pNext = &semaphore_type_create_info}};
+	}
+} // av
@@ -0,0 +1,29 @@
+#ifndef AUDIO_VISUALIZER_FRAMETIMELINE_HPP
+#define AUDIO_VISUALIZER_FRAMETIMELINE_HPP
+
+#include "Gpu.hpp"
+#include "graphics_headers.hpp"
+#include <cstdint>
+
+namespace av {
+	// one timeline semaphore for all frames, frame n signals n when the gpu is done with it
+	// https://www.khronos.org/blog/vulkan-timeline-semaphores
+	// any thread can wait for a frame value (e.g. before overwriting data that frame reads)
+	// only queue submissions signal it, a host signal could race them and break the ordering
+	class FrameTimeline {
+	public:
+		explicit FrameTimeline(Gpu const &);
+		vk::raii::Semaphore const &semaphore{_semaphore};
+		// the highest value signaled so far
+		[[nodiscard]] uint64_t completed_value() const;
+		// false if the timeout ran out first
+		[[nodiscard]] bool wait(uint64_t value, uint64_t timeout_nanoseconds) const;
+
+	private:
+		vk::raii::Device const &device;
+		vk::raii::Semaphore _semaphore;
+		static vk::raii::Semaphore create_semaphore(Gpu const &);
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_FRAMETIMELINE_HPP
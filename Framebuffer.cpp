@@ -12,7 +12,7 @@ namespace av {
 		, _framebuffer{std::move(framebuffer)} {}
 
 	Framebuffers::Framebuffers(
-		GraphicsDevice const &gpu,
+		Gpu const &gpu,
 		SurfaceInfo const &surface_info,
 		vk::raii::SwapchainKHR const &swapchain,
 		vk::raii::RenderPass const &render_pass
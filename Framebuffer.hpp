@@ -22,12 +22,13 @@ namespace av {
 	class Framebuffers : std::vector<Framebuffer> {
 	public:
 		Framebuffers(
-			GraphicsDevice const &,
+			Gpu const &,
 			SurfaceInfo const &,
 			vk::raii::SwapchainKHR const &,
 			vk::raii::RenderPass const &
 		);
 		using std::vector<Framebuffer>::operator[];
+		using std::vector<Framebuffer>::size; // one per swapchain image
 	};
 } // av
 
@@ -0,0 +1,257 @@
+#include "Goertzel.hpp"
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <stdexcept>
+#include <utility>
+
+// goertzel algorithm -- see figure 4 here https://asp-eurasipjournals.springeropen.com/articles/10.1186/1687-6180-2012-56
+// i also used euler's formula to avoid complex arithmetic -- exp(j x) = cos(x) + j sin(x)
+// which ended up giving the algorithm described here https://www.embedded.com/the-goertzel-algorithm/
+/* the classic recurrence, with w = tau frequency / sample_rate and g = 2 cos(w):
+ * s[n] = x[n] + g s[n-1] - s[n-2]
+ * squared magnitude = s[N-1]**2 + s[N-2]**2 - g s[N-1] s[N-2]
+ *
+ * for low frequencies g is within a few ulps of 2, so rounding g to float already moves the filter,
+ * and s[n-1] and s[n-2] are huge and nearly equal so the magnitude is a difference of huge numbers
+ *
+ * the reinsch recurrence tracks d[n] = s[n] - s[n-1] instead, with lambda = g - 2 = -4 sin^2(w / 2),
+ * which is tiny but exactly representable to float precision:
+ * d[n] = x[n] + lambda s[n-1] + d[n-1]
+ * s[n] = s[n-1] + d[n]
+ * squared magnitude = d[N-1]**2 - lambda s[N-1] (s[N-1] - d[N-1])
+ * it's accurate for w < pi / 2, past that the classic recurrence is fine until w gets close to pi
+ * (a mirrored reinsch would handle that, but nothing here analyzes that close to nyquist)
+ */
+
+namespace av {
+	namespace {
+		constexpr long double tau = std::numbers::pi_v<long double> * 2.0l;
+
+		long double angular_frequency(long double frequency, long double sample_rate) {
+			return tau * frequency / sample_rate;
+		}
+
+		// enough independent bins to keep a wide simd unit busy while the state stays in registers
+		constexpr size_t BLOCK_SIZE = 64;
+
+		// runs num_bins <= N bins over all the samples, samples in the outer loop and bins in the inner one
+		// so the inner loop has no dependencies between iterations and vectorizes
+		// N is a compile-time trip count, the generic kernel pads every block to BLOCK_SIZE
+		template<bool reinsch, size_t N>
+		void goertzel_block(
+			float const *coefficients, size_t num_bins, std::span<float const> older, std::span<float const> newer,
+			float *magnitudes
+		) {
+			// reinsch: a = s[n], b = d[n], classic: a = s[n], b = s[n - 1]
+			float c[N]{}, a[N]{}, b[N]{};
+			std::copy_n(coefficients, num_bins, c);
+			for (std::span<float const> samples : {older, newer})
+				for (float x : samples)
+					for (size_t j = 0; j < N; ++j) {
+						if constexpr (reinsch) {
+							b[j] += x + c[j] * a[j];
+							a[j] += b[j];
+						} else {
+							float s0 = x + c[j] * a[j] - b[j];
+							b[j] = a[j];
+							a[j] = s0;
+						}
+					}
+			for (size_t j = 0; j < num_bins; ++j)
+				magnitudes[j] = reinsch
+				                ? b[j] * b[j] - c[j] * a[j] * (a[j] - b[j])
+				                : a[j] * a[j] + b[j] * b[j] - c[j] * a[j] * b[j];
+		}
+
+		// the reinsch bins are a prefix, so every block uses a single recurrence
+		void generic_kernel(
+			float const *coefficients, size_t num_reinsch_bins, size_t num_bins,
+			std::span<float const> older, std::span<float const> newer, float *magnitudes
+		) {
+			for (size_t begin = 0; begin < num_reinsch_bins; begin += BLOCK_SIZE)
+				goertzel_block<true, BLOCK_SIZE>(
+					coefficients + begin, std::min(BLOCK_SIZE, num_reinsch_bins - begin), older, newer,
+					magnitudes + begin);
+			for (size_t begin = num_reinsch_bins; begin < num_bins; begin += BLOCK_SIZE)
+				goertzel_block<false, BLOCK_SIZE>(
+					coefficients + begin, std::min(BLOCK_SIZE, num_bins - begin), older, newer, magnitudes + begin);
+		}
+
+		// trip counts are padded to this, a multiple of every simd width,
+		// because gcc at -O2 only vectorizes loops that need no scalar remainder
+		constexpr size_t LANE_MULTIPLE = 8;
+
+		constexpr size_t padded(size_t num_bins) { return (num_bins + LANE_MULTIPLE - 1) / LANE_MULTIPLE * LANE_MULTIPLE; }
+
+		// every block size is known at compile time, including the partial last block of each recurrence,
+		// so it only gets padded to LANE_MULTIPLE instead of a whole block and every inner loop is fully unrollable
+		template<bool reinsch, size_t NUM_BINS, size_t BLOCK>
+		void fixed_blocks(
+			float const *coefficients, std::span<float const> older, std::span<float const> newer, float *magnitudes
+		) {
+			[&]<size_t... I>(std::index_sequence<I...>) {
+				(goertzel_block<reinsch, padded(std::min(BLOCK, NUM_BINS - I * BLOCK))>(
+					coefficients + I * BLOCK, std::min(BLOCK, NUM_BINS - I * BLOCK), older, newer,
+					magnitudes + I * BLOCK), ...);
+			}(std::make_index_sequence<(NUM_BINS + BLOCK - 1) / BLOCK>{});
+		}
+
+		template<size_t NUM_REINSCH_BINS, size_t NUM_CLASSIC_BINS, size_t BLOCK>
+		void fixed_kernel(
+			float const *coefficients, size_t, size_t,
+			std::span<float const> older, std::span<float const> newer, float *magnitudes
+		) {
+			fixed_blocks<true, NUM_REINSCH_BINS, BLOCK>(coefficients, older, newer, magnitudes);
+			fixed_blocks<false, NUM_CLASSIC_BINS, BLOCK>(
+				coefficients + NUM_REINSCH_BINS, older, newer, magnitudes + NUM_REINSCH_BINS);
+		}
+
+		struct RegistryEntry {
+			size_t num_reinsch_bins;
+			size_t num_classic_bins;
+			Goertzel::Kernel kernel;
+			char const *name;
+		};
+
+		// specializations for the shipped presets, anything else falls back to generic_kernel
+		// lo_frequency 55 hz to hi_frequency 4186 hz in main.cpp at 12, 24, 36 and 48 bins per octave,
+		// which stay below a quarter of any usual sample rate, so they are all reinsch bins
+		// add a line here for a new preset, the bin counts are printed at startup
+		// blocks of 80 measured a bit faster than 48, 64 or 96 once the last block isn't padded to a full block
+		constexpr RegistryEntry registry[]{
+			{76, 0, fixed_kernel<76, 0, 80>, "76 reinsch bins, blocks of 80"},
+			{151, 0, fixed_kernel<151, 0, 80>, "151 reinsch bins, blocks of 80"},
+			{226, 0, fixed_kernel<226, 0, 80>, "226 reinsch bins, blocks of 80"},
+			{301, 0, fixed_kernel<301, 0, 80>, "301 reinsch bins, blocks of 80"},
+		};
+	}
+
+	Goertzel::Goertzel(std::span<long double const> frequencies, long double sample_rate)
+		: _num_reinsch_bins{0}
+		, coefficients(frequencies.size()) {
+		if (!std::ranges::is_sorted(frequencies))
+			throw std::invalid_argument("goertzel frequencies must be ascending");
+		// ascending frequencies, so the reinsch bins are a prefix
+		while (_num_reinsch_bins < frequencies.size()
+		       && angular_frequency(frequencies[_num_reinsch_bins], sample_rate) < tau / 4.0l)
+			++_num_reinsch_bins;
+		for (size_t i = 0; i < frequencies.size(); ++i) {
+			long double w = angular_frequency(frequencies[i], sample_rate);
+			long double half_sine = std::sin(w / 2.0l);
+			coefficients[i] = static_cast<float>(
+				i < _num_reinsch_bins ? -4.0l * half_sine * half_sine : 2.0l * std::cos(w));
+		}
+		kernel = generic_kernel;
+		_kernel_name = "generic";
+		for (RegistryEntry const &entry : registry)
+			if (entry.num_reinsch_bins == _num_reinsch_bins
+			    && entry.num_reinsch_bins + entry.num_classic_bins == coefficients.size()) {
+				kernel = entry.kernel;
+				_kernel_name = entry.name;
+			}
+	}
+
+	void Goertzel::compute(std::span<float const> older, std::span<float const> newer, std::span<float> magnitudes) {
+		AV_TRACE_SCOPE("goertzel");
+		kernel(coefficients.data(), _num_reinsch_bins, coefficients.size(), older, newer, magnitudes.data());
+	}
+
+	namespace {
+		// the kernel from before the reinsch bins, everything classic and the state swept once per sample
+		template<typename T>
+		std::vector<float> classic_goertzel(
+			std::span<long double const> frequencies, long double sample_rate, std::span<float const> samples
+		) {
+			std::vector<T> g(frequencies.size()), s1(frequencies.size()), s2(frequencies.size());
+			for (size_t i = 0; i < frequencies.size(); ++i)
+				g[i] = static_cast<T>(2.0l * std::cos(angular_frequency(frequencies[i], sample_rate)));
+			for (float x : samples)
+				for (size_t i = 0; i < frequencies.size(); ++i) {
+					T s0 = x + g[i] * s1[i] - s2[i];
+					s2[i] = s1[i];
+					s1[i] = s0;
+				}
+			std::vector<float> magnitudes(frequencies.size());
+			for (size_t i = 0; i < frequencies.size(); ++i)
+				magnitudes[i] = static_cast<float>(s1[i] * s1[i] + s2[i] * s2[i] - g[i] * s1[i] * s2[i]);
+			return magnitudes;
+		}
+
+		template<typename Kernel>
+		double nanoseconds_per_sample_bin(Kernel const &kernel, size_t num_samples, size_t num_bins) {
+			constexpr int repetitions = 20;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < repetitions; ++r) kernel();
+			std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+			return elapsed.count() / repetitions / static_cast<double>(num_samples * num_bins);
+		}
+	}
+
+	void Goertzel::print_report(std::span<long double const> frequencies, long double sample_rate, size_t num_samples) {
+		// a few partials on and between the bins, plus a bit of noise so the quiet bins aren't exactly 0
+		std::vector<float> samples(num_samples);
+		uint32_t noise = 12345;
+		for (size_t n = 0; n < num_samples; ++n) {
+			long double sample = 0.0l;
+			for (long double partial : {frequencies.front(), frequencies.front() * 1.5l, 440.0l, frequencies.back()})
+				sample += 0.2l * std::sin(angular_frequency(partial, sample_rate) * static_cast<long double>(n));
+			noise = noise * 1664525u + 1013904223u;
+			sample += 1e-3l * (static_cast<long double>(noise) / 4294967296.0l - 0.5l);
+			samples[n] = static_cast<float>(sample);
+		}
+
+		std::vector<long double> reference(frequencies.size());
+		for (size_t i = 0; i < frequencies.size(); ++i) {
+			long double re = 0.0l, im = 0.0l, w = angular_frequency(frequencies[i], sample_rate);
+			for (size_t n = 0; n < num_samples; ++n) {
+				re += samples[n] * std::cos(w * static_cast<long double>(n));
+				im -= samples[n] * std::sin(w * static_cast<long double>(n));
+			}
+			reference[i] = re * re + im * im;
+		}
+
+		Goertzel goertzel{frequencies, sample_rate};
+		std::vector<float> mixed(frequencies.size()), fixed(frequencies.size());
+		auto run_mixed = [&] {
+			generic_kernel(
+				goertzel.coefficients.data(), goertzel.num_reinsch_bins, frequencies.size(), samples, {}, mixed.data());
+		};
+		auto run_fixed = [&] { goertzel.compute(samples, {}, fixed); };
+		auto run_float = [&] { return classic_goertzel<float>(frequencies, sample_rate, samples); };
+		auto run_double = [&] { return classic_goertzel<double>(frequencies, sample_rate, samples); };
+		run_mixed();
+		run_fixed();
+
+		auto print_row = [&](char const *name, std::vector<float> const &magnitudes, double nanoseconds) {
+			double worst_db = 0.0, total_db = 0.0;
+			size_t worst_bin = 0;
+			for (size_t i = 0; i < magnitudes.size(); ++i) {
+				double error_db = std::abs(10.0 * std::log10(
+					std::max(static_cast<double>(magnitudes[i]), 1e-30) / static_cast<double>(reference[i])));
+				total_db += error_db;
+				if (error_db > worst_db) worst_db = error_db, worst_bin = i;
+			}
+			std::cout << std::setw(16) << name
+			          << std::setw(14) << worst_db << " db at " << std::setw(8) << static_cast<double>(frequencies[worst_bin])
+			          << " hz" << std::setw(14) << total_db / static_cast<double>(magnitudes.size()) << " db"
+			          << std::setw(12) << nanoseconds << " ns\n";
+		};
+		std::cout << "goertzel vs long double dft, " << frequencies.size() << " bins, " << num_samples << " samples, "
+		          << goertzel.num_reinsch_bins << " reinsch bins, kernel " << goertzel.kernel_name << '\n'
+		          << std::setw(16) << "kernel" << std::setw(32) << "worst error" << std::setw(17) << "mean error"
+		          << std::setw(15) << "per sample-bin" << '\n';
+		print_row("float classic", run_float(), nanoseconds_per_sample_bin(run_float, num_samples, frequencies.size()));
+		print_row("mixed generic", mixed, nanoseconds_per_sample_bin(run_mixed, num_samples, frequencies.size()));
+		print_row("mixed fixed", fixed, nanoseconds_per_sample_bin(run_fixed, num_samples, frequencies.size()));
+		print_row("double classic", run_double(), nanoseconds_per_sample_bin(run_double, num_samples, frequencies.size()));
+		std::cout << std::endl;
+	}
+} // av
@@ -0,0 +1,42 @@
+#ifndef AUDIO_VISUALIZER_GOERTZEL_HPP
+#define AUDIO_VISUALIZER_GOERTZEL_HPP
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace av {
+	// squared dft magnitudes at arbitrary frequencies, one goertzel filter per frequency
+	// every bin picks the recurrence that stays accurate in float for its frequency (see Goertzel.cpp),
+	// so the low bins don't need double accumulators
+	class Goertzel {
+	public:
+		Goertzel(std::span<long double const> frequencies, long double sample_rate);
+
+		// the samples are older followed by newer, so a wrapped ring buffer can be passed without copying
+		// magnitudes must hold one float per frequency
+		void compute(std::span<float const> older, std::span<float const> newer, std::span<float> magnitudes);
+
+		// bins below this use the reinsch recurrence, the rest the classic one
+		size_t const &num_reinsch_bins{_num_reinsch_bins};
+		// "generic", or the compile-time specialization that matched the bin counts (see the registry in Goertzel.cpp)
+		char const *const &kernel_name{_kernel_name};
+
+		// compares the float kernels and a double one against a long double dft on a synthetic signal,
+		// then times them
+		static void print_report(std::span<long double const> frequencies, long double sample_rate, size_t num_samples);
+
+		using Kernel = void (*)(
+			float const *coefficients, size_t num_reinsch_bins, size_t num_bins,
+			std::span<float const> older, std::span<float const> newer, float *magnitudes);
+
+	private:
+		size_t _num_reinsch_bins;
+		// reinsch bins: lambda = -4 sin^2(w / 2), the rest: 2 cos(w)
+		std::vector<float> coefficients;
+		Kernel kernel;
+		char const *_kernel_name;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_GOERTZEL_HPP
@@ -1,6 +1,8 @@
 #include "Gpu.hpp"
 
 #include "constants.hpp"
+#include <algorithm>
+#include <cstring>
 #include <optional>
 #include <ranges>
 #include <stdexcept>
@@ -14,19 +16,42 @@ namespace av {
 		vk::raii::SurfaceKHR const &surface
 	)
 		: physical_device{choose_physical_device(instance, surface)}
+		, api_version{std::min(physical_device.getProperties().apiVersion, constants::VK_API_VERSION)}
 		, queue_family_indices{*QueueFamilyIndices::get_queue_family_indices(physical_device, surface)}
-		, device{create_device(physical_device, queue_family_indices)}
+		, timestamp_period{physical_device.getProperties().limits.timestampPeriod}
+		, timestamp_valid_bits{
+			physical_device.getQueueFamilyProperties()[queue_family_indices.graphics].timestampValidBits}
+		, device{create_device(physical_device, api_version, queue_family_indices)}
 		, graphics_queue{device, queue_family_indices.graphics, 0}
 		, present_queue{device, queue_family_indices.present, 0}
-		, graphics_command_pool{create_graphics_command_pool(device, queue_family_indices.graphics)}
-		, allocator{create_allocator(instance, physical_device, device)} {}
+		, graphics_command_pool{create_command_pool(device, queue_family_indices.graphics)}
+		, transfer_queue{queue_family_indices.transfer
+		                 ? vk::raii::Queue{device, *queue_family_indices.transfer, 0}
+		                 : vk::raii::Queue{nullptr}}
+		, transfer_command_pool{queue_family_indices.transfer
+		                        ? create_command_pool(device, *queue_family_indices.transfer)
+		                        : vk::raii::CommandPool{nullptr}}
+		, allocator{create_allocator(instance, physical_device, api_version, device)} {}
 
 	std::optional<Gpu::QueueFamilyIndices> Gpu::QueueFamilyIndices::get_queue_family_indices(
 		vk::raii::PhysicalDevice const &physical_device,
 		vk::raii::SurfaceKHR const &surface
 	) {
-		std::optional<uint32_t> graphics_queue_family_index, present_queue_family_index;
+		std::optional<uint32_t> graphics_queue_family_index, present_queue_family_index, transfer_queue_family_index;
 		auto queue_families_properties = physical_device.getQueueFamilyProperties();
+		// prefer a pure copy engine over a compute family that can also transfer
+		for (uint32_t queue_family_index = 0;
+		     queue_family_index < queue_families_properties.size(); ++queue_family_index) {
+			vk::QueueFlags queue_flags = queue_families_properties[queue_family_index].queueFlags;
+			if (!(queue_flags & vk::QueueFlagBits::eTransfer) || (queue_flags & vk::QueueFlagBits::eGraphics))
+				continue;
+			if (!(queue_flags & vk::QueueFlagBits::eCompute)) {
+				transfer_queue_family_index = queue_family_index;
+				break;
+			}
+			if (!transfer_queue_family_index.has_value())
+				transfer_queue_family_index = queue_family_index;
+		}
 		for (uint32_t queue_family_index = 0;
 		     queue_family_index < queue_families_properties.size(); ++queue_family_index) {
 			bool supports_graphics = static_cast<bool>(queue_families_properties[queue_family_index].queueFlags &
@@ -45,6 +70,7 @@ namespace av {
 			return QueueFamilyIndices{
 				.graphics= *graphics_queue_family_index,
 				.present = *present_queue_family_index,
+				.transfer = transfer_queue_family_index,
 			};
 		else return std::nullopt;
 	}
@@ -53,6 +79,21 @@ namespace av {
 		allocator.destroy();
 	}
 
+	// core in 1.2, an extension before that
+	bool Gpu::supports_timeline_semaphores(vk::raii::PhysicalDevice const &physical_device) {
+		if (physical_device.getProperties().apiVersion < VK_API_VERSION_1_2
+		    && std::ranges::none_of(
+			physical_device.enumerateDeviceExtensionProperties(),
+			[](vk::ExtensionProperties const &extension_properties) {
+				return std::strcmp(extension_properties.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0;
+			}))
+			return false;
+		return physical_device.getFeatures2<
+			vk::PhysicalDeviceFeatures2,
+			vk::PhysicalDeviceTimelineSemaphoreFeatures
+		>().get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().timelineSemaphore;
+	}
+
 	bool Gpu::physical_device_is_compatible(
 		vk::raii::PhysicalDevice const &physical_device,
 		vk::raii::SurfaceKHR const &surface
@@ -72,6 +113,8 @@ namespace av {
 				});
 			if (!supports_all_extensions) return false;
 		}
+		if (!supports_timeline_semaphores(physical_device))
+			return false;
 		if (!QueueFamilyIndices::get_queue_family_indices(physical_device, surface).has_value())
 			return false;
 		if (physical_device.getSurfaceFormatsKHR(*surface).empty())
@@ -102,6 +145,7 @@ namespace av {
 
 	vk::raii::Device Gpu::create_device(
 		vk::raii::PhysicalDevice const &physical_device,
+		uint32_t api_version,
 		Gpu::QueueFamilyIndices const &queue_family_indices
 	) {
 		std::vector<vk::DeviceQueueCreateInfo> device_queue_create_infos;
@@ -119,26 +163,39 @@ namespace av {
 					.queueCount = 1,
 					.pQueuePriorities = &queue_priority,
 				});
+		if (queue_family_indices.transfer)
+			device_queue_create_infos.push_back(
+				{
+					.queueFamilyIndex = *queue_family_indices.transfer,
+					.queueCount = 1,
+					.pQueuePriorities = &queue_priority,
+				});
+		std::vector<char const *> device_extensions(
+			constants::DEVICE_EXTENSIONS.begin(), constants::DEVICE_EXTENSIONS.end());
+		if (api_version < VK_API_VERSION_1_2)
+			device_extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		vk::PhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features{.timelineSemaphore = true};
 		vk::PhysicalDeviceFeatures enabled_features;
 		vk::DeviceCreateInfo device_create_info{
+			.pNext = &timeline_semaphore_features,
 			.queueCreateInfoCount = static_cast<uint32_t>(device_queue_create_infos.size()),
 			.pQueueCreateInfos = device_queue_create_infos.data(),
 			.enabledLayerCount = static_cast<uint32_t>(constants::GLOBAL_LAYERS.size()),
 			.ppEnabledLayerNames = constants::GLOBAL_LAYERS.data(),
-			.enabledExtensionCount = constants::DEVICE_EXTENSIONS.size(),
-			.ppEnabledExtensionNames = constants::DEVICE_EXTENSIONS.data(),
+			.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size()),
+			.ppEnabledExtensionNames = device_extensions.data(),
 			.pEnabledFeatures = &enabled_features,
 		};
 		return {physical_device, device_create_info};
 	}
 
-	vk::raii::CommandPool Gpu::create_graphics_command_pool(
+	vk::raii::CommandPool Gpu::create_command_pool(
 		vk::raii::Device const &device,
-		uint32_t graphics_queue_family_index
+		uint32_t queue_family_index
 	) {
 		vk::CommandPoolCreateInfo command_pool_create_info{
 			.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-			.queueFamilyIndex = graphics_queue_family_index,
+			.queueFamilyIndex = queue_family_index,
 		};
 		return {device, command_pool_create_info};
 	}
@@ -146,13 +203,14 @@ namespace av {
 	vma::Allocator Gpu::create_allocator(
 		vk::raii::Instance const &instance,
 		vk::raii::PhysicalDevice const &physical_device,
+		uint32_t api_version,
 		vk::raii::Device const &device
 	) {
 		vma::AllocatorCreateInfo allocator_create_info{
 			.physicalDevice = *physical_device,
 			.device = *device,
 			.instance = *instance,
-			.vulkanApiVersion = constants::VK_API_VERSION,
+			.vulkanApiVersion = VK_MAKE_API_VERSION(0, VK_API_VERSION_MAJOR(api_version), VK_API_VERSION_MINOR(api_version), 0),
 		};
 		return vma::createAllocator(allocator_create_info);
 	}
@@ -12,6 +12,7 @@ namespace av {
 		struct QueueFamilyIndices {
 			uint32_t const graphics;
 			uint32_t const present;
+			std::optional<uint32_t> const transfer; // a family that can transfer but not draw, if there is one
 			static std::optional<QueueFamilyIndices> get_queue_family_indices(
 				vk::raii::PhysicalDevice const &,
 				vk::raii::SurfaceKHR const &
@@ -19,14 +20,21 @@ namespace av {
 		};
 
 		vk::raii::PhysicalDevice const physical_device;
+		uint32_t const api_version; // the lower of the device's and constants::VK_API_VERSION
 		QueueFamilyIndices const queue_family_indices;
+		float const timestamp_period; // nanoseconds per timestamp tick
+		uint32_t const timestamp_valid_bits; // 0 if the graphics queue does not support timestamps
 		vk::raii::Device const device;
 		vk::raii::Queue const graphics_queue;
 		vk::raii::Queue const present_queue;
 		vk::raii::CommandPool const graphics_command_pool;
+		// null without a dedicated transfer family, see UploadBuffer
+		vk::raii::Queue const transfer_queue;
+		vk::raii::CommandPool const transfer_command_pool;
 		vma::Allocator const allocator;
 
 	private:
+		static bool supports_timeline_semaphores(vk::raii::PhysicalDevice const &);
 		static bool physical_device_is_compatible(
 			vk::raii::PhysicalDevice const &,
 			vk::raii::SurfaceKHR const &
@@ -37,15 +45,17 @@ namespace av {
 		);
 		static vk::raii::Device create_device(
 			vk::raii::PhysicalDevice const &,
+			uint32_t api_version,
 			QueueFamilyIndices const &
 		);
-		static vk::raii::CommandPool create_graphics_command_pool(
+		static vk::raii::CommandPool create_command_pool(
 			vk::raii::Device const &,
-			uint32_t graphics_queue_family_index
+			uint32_t queue_family_index
 		);
 		static vma::Allocator create_allocator(
 			vk::raii::Instance const &,
 			vk::raii::PhysicalDevice const &,
+			uint32_t api_version,
 			vk::raii::Device const &
 		);
 	};
@@ -1,7 +1,7 @@
 #include "constants.hpp"
 
 #include "GraphicsState.hpp"
-#include "Vertex.hpp"
+#include "MagnitudeEncoding.hpp"
 
 #include <algorithm>
 #include <array>
@@ -16,16 +16,21 @@ namespace av {
 	GraphicsState::GraphicsState(
 		vk::raii::SurfaceKHR const &surface,
 		Gpu const &gpu,
-		std::tuple<size_t, size_t> const &framebuffer_size
+		std::tuple<size_t, size_t> const &framebuffer_size,
+		PipelineDescription const &pipeline_description,
+		LatencyPolicy latency_policy
 	)
-		: _vertex_shader_module{create_shader_module(constants::VERTEX_SHADER_FILE_NAME, gpu)}
-		, _fragment_shader_module{create_shader_module(constants::FRAGMENT_SHADER_FILE_NAME, gpu)}
-		, _pipeline_layout{create_pipeline_layout(gpu)}
-		, _surface_info{surface, gpu, framebuffer_size}
+		: _pipeline_description{pipeline_description}
+		, _vertex_shader_module{create_shader_module(pipeline_description.vertex_shader_file_name, gpu)}
+		, _fragment_shader_module{create_shader_module(pipeline_description.fragment_shader_file_name, gpu)}
+		, _pipeline_layout{create_pipeline_layout(gpu, pipeline_description)}
+		, _latency_policy{latency_policy}
+		, _surface_info{surface, gpu, framebuffer_size, latency_policy}
 		, _swapchain{create_swapchain(surface, gpu, surface_info, nullptr)}
 		, _render_pass{create_render_pass(gpu, surface_info)}
 		, _pipeline{create_pipeline(
-			gpu, _vertex_shader_module, _fragment_shader_module, _pipeline_layout, surface_info, render_pass)}
+			gpu, _vertex_shader_module, _fragment_shader_module, _pipeline_layout, surface_info, render_pass,
+			_pipeline_description)}
 		, _framebuffers{gpu, surface_info, swapchain, render_pass} {}
 
 
@@ -36,11 +41,12 @@ namespace av {
 	) {
 		// placement new https://stackoverflow.com/a/54645552
 		std::destroy_at(&_surface_info);
-		std::construct_at(&_surface_info, surface, gpu, framebuffer_size);
+		std::construct_at(&_surface_info, surface, gpu, framebuffer_size, _latency_policy);
 		_swapchain = create_swapchain(surface, gpu, _surface_info, _swapchain);
 		_render_pass = create_render_pass(gpu, _surface_info);
 		_pipeline = create_pipeline(
-			gpu, _vertex_shader_module, _fragment_shader_module, _pipeline_layout, _surface_info, _render_pass);
+			gpu, _vertex_shader_module, _fragment_shader_module, _pipeline_layout, _surface_info, _render_pass,
+			_pipeline_description);
 		_framebuffers = Framebuffers(gpu, surface_info, swapchain, render_pass);
 	}
 
@@ -62,10 +68,15 @@ namespace av {
 		return {gpu.device, shader_module_create_info};
 	}
 
-	vk::raii::PipelineLayout GraphicsState::create_pipeline_layout(Gpu const &gpu) {
+	vk::raii::PipelineLayout GraphicsState::create_pipeline_layout(
+		Gpu const &gpu,
+		PipelineDescription const &pipeline_description
+	) {
 		vk::PipelineLayoutCreateInfo pipeline_layout_create_info{
-			.setLayoutCount = 0,
-			.pushConstantRangeCount = 0,
+			.setLayoutCount = static_cast<uint32_t>(pipeline_description.set_layouts.size()),
+			.pSetLayouts = pipeline_description.set_layouts.data(),
+			.pushConstantRangeCount = static_cast<uint32_t>(pipeline_description.push_constant_ranges.size()),
+			.pPushConstantRanges = pipeline_description.push_constant_ranges.data(),
 		};
 		return {gpu.device, pipeline_layout_create_info};
 	}
@@ -82,10 +93,7 @@ namespace av {
 		};
 		vk::SwapchainCreateInfoKHR swapchain_create_info{
 			.surface = *surface,
-			.minImageCount = surface_info.surface_capabilities.maxImageCount == 0
-			                 ? surface_info.surface_capabilities.minImageCount + 1
-			                 : std::min(surface_info.surface_capabilities.minImageCount + 1,
-			                            surface_info.surface_capabilities.maxImageCount),
+			.minImageCount = surface_info.image_count,
 			.imageFormat = surface_info.surface_format.format,
 			.imageColorSpace = surface_info.surface_format.colorSpace,
 			.imageExtent = surface_info.extent,
@@ -150,27 +158,43 @@ namespace av {
 		vk::raii::ShaderModule const &fragment_shader_module,
 		vk::raii::PipelineLayout const &pipeline_layout,
 		SurfaceInfo const &surface_info,
-		vk::raii::RenderPass const &render_pass
+		vk::raii::RenderPass const &render_pass,
+		PipelineDescription const &pipeline_description
 	) {
+		// constant_id 0 in shaders/common.glsl, so the shaders decode with the same floor the cpu encodes with
+		vk::SpecializationMapEntry specialization_map_entry{
+			.constantID = 0,
+			.offset = 0,
+			.size = sizeof(MAGNITUDE_FLOOR_DB),
+		};
+		vk::SpecializationInfo specialization_info{
+			.mapEntryCount = 1,
+			.pMapEntries = &specialization_map_entry,
+			.dataSize = sizeof(MAGNITUDE_FLOOR_DB),
+			.pData = &MAGNITUDE_FLOOR_DB,
+		};
 		vk::PipelineShaderStageCreateInfo vertex_shader_stage_create_info{
 			.stage = vk::ShaderStageFlagBits::eVertex,
 			.module = *vertex_shader_module,
 			.pName = "main",
+			.pSpecializationInfo = &specialization_info,
 		};
 		vk::PipelineShaderStageCreateInfo fragment_shader_stage_info{
 			.stage = vk::ShaderStageFlagBits::eFragment,
 			.module = *fragment_shader_module,
 			.pName = "main",
+			.pSpecializationInfo = &specialization_info,
 		};
 		std::array pipeline_shader_stage_create_infos{vertex_shader_stage_create_info, fragment_shader_stage_info};
 		vk::PipelineVertexInputStateCreateInfo pipeline_vertex_input_state_create_info{
-			.vertexBindingDescriptionCount = 1,
-			.pVertexBindingDescriptions = &Vertex::binding_description,
-			.vertexAttributeDescriptionCount = Vertex::attribute_descriptions.size(),
-			.pVertexAttributeDescriptions = Vertex::attribute_descriptions.data(),
+			.vertexBindingDescriptionCount = static_cast<uint32_t>(pipeline_description.binding_descriptions.size()),
+			.pVertexBindingDescriptions = pipeline_description.binding_descriptions.data(),
+			.vertexAttributeDescriptionCount =
+				static_cast<uint32_t>(pipeline_description.attribute_descriptions.size()),
+			.pVertexAttributeDescriptions = pipeline_description.attribute_descriptions.data(),
 		};
 		vk::PipelineInputAssemblyStateCreateInfo pipeline_input_assembly_state_create_info{
-			.topology = vk::PrimitiveTopology::eTriangleStrip,
+			.topology = pipeline_description.topology,
 			.primitiveRestartEnable = false,
 		};
 		vk::Extent2D const &swapchain_extent = surface_info.extent;
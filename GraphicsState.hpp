@@ -2,6 +2,7 @@
 #define AUDIO_VISUALIZER_GRAPHICSSTATE_HPP
 
 #include "Gpu.hpp"
+#include "PipelineDescription.hpp"
 #include "SurfaceInfo.hpp"
 #include "Framebuffer.hpp"
 #include "graphics_headers.hpp"
@@ -9,26 +10,33 @@
 
 namespace av {
 	class GraphicsState {
+	public:
 		GraphicsState(
 			vk::raii::SurfaceKHR const &,
 			Gpu const &,
-			std::tuple<size_t, size_t> const &framebuffer_size
+			std::tuple<size_t, size_t> const &framebuffer_size,
+			PipelineDescription const &,
+			LatencyPolicy
 		);
 		void recreate(
 			vk::raii::SurfaceKHR const &,
 			Gpu const &,
 			std::tuple<size_t, size_t> const &framebuffer_size
 		);
+		LatencyPolicy const &latency_policy{_latency_policy};
 		SurfaceInfo const &surface_info{_surface_info};
 		vk::raii::SwapchainKHR const &swapchain{_swapchain};
 		vk::raii::RenderPass const &render_pass{_render_pass};
+		vk::raii::PipelineLayout const &pipeline_layout{_pipeline_layout};
 		vk::raii::Pipeline const &pipeline{_pipeline};
 		Framebuffers const &framebuffers{_framebuffers};
 
 	private:
+		PipelineDescription const _pipeline_description;
 		vk::raii::ShaderModule const _vertex_shader_module;
 		vk::raii::ShaderModule const _fragment_shader_module;
 		vk::raii::PipelineLayout const _pipeline_layout;
+		LatencyPolicy const _latency_policy;
 		SurfaceInfo _surface_info;
 		vk::raii::SwapchainKHR _swapchain;
 		vk::raii::RenderPass _render_pass;
@@ -38,7 +46,7 @@ namespace av {
 			std::string const &file_name,
 			Gpu const &
 		);
-		static vk::raii::PipelineLayout create_pipeline_layout(Gpu const &);
+		static vk::raii::PipelineLayout create_pipeline_layout(Gpu const &, PipelineDescription const &);
 		static vk::raii::SwapchainKHR create_swapchain(
 			vk::raii::SurfaceKHR const &,
 			Gpu const &,
@@ -52,7 +60,8 @@ namespace av {
 			vk::raii::ShaderModule const &fragment_shader_module,
 			vk::raii::PipelineLayout const &pipeline_layout,
 			SurfaceInfo const &,
-			vk::raii::RenderPass const &
+			vk::raii::RenderPass const &,
+			PipelineDescription const &
 		);
 	};
 } // av
@@ -0,0 +1,116 @@
+#include "InstanceBuffer.hpp"
+
+#include "constants.hpp"
+#include <algorithm>
+#include <array>
+
+namespace av {
+	std::array<vk::PushConstantRange, 1> const InstanceBuffer::push_constant_ranges{
+		vk::PushConstantRange{
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.offset = 0,
+			.size = sizeof(PushConstants),
+		},
+	};
+
+	void InstanceBuffer::bind_and_draw(
+		vk::raii::CommandBuffer const &command_buffer,
+		vk::raii::PipelineLayout const &pipeline_layout
+	) const {
+		vk::Buffer const buffer = *_upload_buffer.buffer;
+		vk::DeviceSize const newest_offset = MAGNITUDES_OFFSET + _slots.newest() * _slot_size;
+		vk::DeviceSize const previous_offset = MAGNITUDES_OFFSET + _slots.previous() * _slot_size;
+		command_buffer.bindVertexBuffers(0, {buffer, buffer, buffer}, {0, newest_offset, previous_offset});
+		command_buffer.pushConstants<PushConstants>(
+			*pipeline_layout, vk::ShaderStageFlagBits::eVertex, 0, _push_constants);
+		command_buffer.draw(NUM_QUAD_VERTICES, _push_constants.num_instances, 0, 0);
+	}
+
+	void InstanceBuffer::commit_magnitudes() {
+		_slots.commit();
+		_magnitude_data = _upload_buffer.data.subspan(MAGNITUDES_OFFSET + _slots.write() * _slot_size, _slot_size);
+	}
+
+	void InstanceBuffer::mark_drawn(uint64_t frame_value) {
+		_slots.mark_drawn(frame_value);
+	}
+
+	uint64_t InstanceBuffer::write_frame_value() const {
+		return _slots.write_frame_value();
+	}
+
+	void InstanceBuffer::set_blend(float blend) {
+		_push_constants.blend = blend;
+	}
+
+	InstanceBuffer::InstanceBuffer(
+		BarLayout const &layout,
+		Gpu const &gpu,
+		vma::Allocator const &allocator,
+		UploadStrategy upload_strategy
+	)
+		: magnitude_format{layout.magnitude_format}
+		, _push_constants{
+			.num_instances = layout.num_bars,
+			.instances_per_octave = layout.bars_per_octave,
+			.blend = 1.0f,
+		}
+		, _binding_descriptions{
+			vk::VertexInputBindingDescription{
+				.binding = 0,
+				.stride = sizeof(Vertex::Position),
+				.inputRate = vk::VertexInputRate::eVertex,
+			},
+			vk::VertexInputBindingDescription{
+				.binding = 1,
+				.stride = static_cast<uint32_t>(magnitude_size(layout.magnitude_format)),
+				.inputRate = vk::VertexInputRate::eInstance,
+			},
+			vk::VertexInputBindingDescription{
+				.binding = 2,
+				.stride = static_cast<uint32_t>(magnitude_size(layout.magnitude_format)),
+				.inputRate = vk::VertexInputRate::eInstance,
+			},
+		}
+		, _attribute_descriptions{
+			vk::VertexInputAttributeDescription{
+				.location = 0,
+				.binding = 0,
+				.format = vk::Format::eR32G32Sfloat,
+				.offset = 0,
+			},
+			vk::VertexInputAttributeDescription{
+				.location = 1,
+				.binding = 1,
+				.format = magnitude_vk_format(layout.magnitude_format),
+				.offset = 0,
+			},
+			vk::VertexInputAttributeDescription{
+				.location = 2,
+				.binding = 2,
+				.format = magnitude_vk_format(layout.magnitude_format),
+				.offset = 0,
+			},
+		}
+		, _pipeline_description{
+			.vertex_shader_file_name = constants::BARS_VERTEX_SHADER_FILE_NAME,
+			.fragment_shader_file_name = constants::FRAGMENT_SHADER_FILE_NAME,
+			.binding_descriptions = _binding_descriptions,
+			.attribute_descriptions = _attribute_descriptions,
+			.topology = vk::PrimitiveTopology::eTriangleStrip,
+			.push_constant_ranges = push_constant_ranges,
+		}
+		, _slot_size{layout.num_bars * magnitude_size(layout.magnitude_format)}
+		, _upload_buffer{
+			gpu, allocator, MAGNITUDES_OFFSET + MagnitudeSlots::NUM_SLOTS * _slot_size,
+			vk::BufferUsageFlagBits::eVertexBuffer,
+			MAGNITUDES_OFFSET, MagnitudeSlots::NUM_SLOTS * _slot_size,
+			upload_strategy
+		}
+		, _magnitude_data{_upload_buffer.data.subspan(MAGNITUDES_OFFSET, _slot_size)} {
+		// triangle strip
+		std::array<Vertex::Position, NUM_QUAD_VERTICES> quad{{{0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}}};
+		std::ranges::copy(quad, reinterpret_cast<Vertex::Position *>(_upload_buffer.data.data()));
+		std::ranges::fill(_upload_buffer.data.subspan(MAGNITUDES_OFFSET), std::byte{0}); // encodes 0 in every format
+	}
+} // av
@@ -0,0 +1,67 @@
+#ifndef AUDIO_VISUALIZER_INSTANCEBUFFER_HPP
+#define AUDIO_VISUALIZER_INSTANCEBUFFER_HPP
+
+#include "Gpu.hpp"
+#include "Layout.hpp"
+#include "MagnitudeEncoding.hpp"
+#include "MagnitudeSlots.hpp"
+#include "PipelineDescription.hpp"
+#include "UploadBuffer.hpp"
+#include "Vertex.hpp"
+#include "graphics_headers.hpp"
+#include <array>
+#include <span>
+
+namespace av {
+	// a unit quad drawn once per instance, with one encoded magnitude per instance
+	// the vertex shader derives everything else from gl_InstanceIndex and the push constants
+	// the two newest analysis frames are blended in the shader,
+	// so the bars move smoothly when the display runs faster than the analysis
+	// they live in a ring of slots side by side, see MagnitudeSlots
+	class InstanceBuffer {
+	public:
+		InstanceBuffer(
+			BarLayout const &,
+			Gpu const &,
+			vma::Allocator const &,
+			UploadStrategy
+		);
+		void bind_and_draw(vk::raii::CommandBuffer const &, vk::raii::PipelineLayout const &) const;
+		// after writing a frame into magnitude_data, it becomes the newest and magnitude_data moves to the next slot
+		// wait for write_frame_value on the FrameTimeline before writing into it
+		void commit_magnitudes();
+		// frame_value is signaled once the frame just recorded is done reading the slots
+		void mark_drawn(uint64_t frame_value);
+		[[nodiscard]] uint64_t write_frame_value() const;
+		// 0 draws the previous frame, 1 the newest
+		void set_blend(float);
+		// see encode_magnitudes, only valid until the next commit_magnitudes
+		std::span<std::byte> const &magnitude_data{_magnitude_data};
+		// only the magnitudes are uploaded every frame
+		UploadBuffer const &upload_buffer{_upload_buffer};
+		MagnitudeFormat const magnitude_format;
+		PipelineDescription const &pipeline_description{_pipeline_description};
+
+		struct PushConstants {
+			uint32_t num_instances;
+			uint32_t instances_per_octave;
+			float blend;
+		};
+
+	private:
+		static constexpr size_t NUM_QUAD_VERTICES = 4;
+		PushConstants _push_constants;
+		std::array<vk::VertexInputBindingDescription, 3> const _binding_descriptions;
+		std::array<vk::VertexInputAttributeDescription, 3> const _attribute_descriptions;
+		PipelineDescription const _pipeline_description; // after everything it points into
+		static constexpr size_t MAGNITUDES_OFFSET = NUM_QUAD_VERTICES * sizeof(Vertex::Position);
+		size_t const _slot_size; // one frame of encoded magnitudes
+		UploadBuffer const _upload_buffer;
+		MagnitudeSlots _slots;
+		std::span<std::byte> _magnitude_data;
+
+		static std::array<vk::PushConstantRange, 1> const push_constant_ranges;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_INSTANCEBUFFER_HPP
@@ -0,0 +1,47 @@
+#ifndef AUDIO_VISUALIZER_LATENCYPOLICY_HPP
+#define AUDIO_VISUALIZER_LATENCYPOLICY_HPP
+
+#include "constants.hpp"
+
+#include <cstddef>
+
+namespace av {
+	// how far the picture on screen may lag behind the magnitudes it was drawn from
+	// picks the present mode, the swapchain image count and the number of frames in flight together,
+	// since each one on its own just moves the queue somewhere else
+	enum class LatencyPolicy {
+		// mailbox (immediate without it), no spare swapchain images beyond what the mode needs, one frame in flight
+		// the newest frame always wins, older ones are thrown away or torn
+		lowest_latency,
+		// mailbox (fifo without it), one spare swapchain image, two frames in flight
+		// cpu and gpu overlap so a slow frame doesn't stall the next one
+		smooth,
+		// fifo, the minimum number of swapchain images, one frame in flight
+		// never renders more frames than the display shows
+		power_saving,
+	};
+
+	constexpr size_t get_frames_in_flight(LatencyPolicy policy) {
+		switch (policy) {
+			case LatencyPolicy::smooth:
+				return 2;
+			default:
+				return 1;
+		}
+	}
+
+	constexpr char const *to_string(LatencyPolicy policy) {
+		switch (policy) {
+			case LatencyPolicy::lowest_latency:
+				return "lowest latency";
+			case LatencyPolicy::smooth:
+				return "smooth";
+			default:
+				return "power saving";
+		}
+	}
+
+	static_assert(get_frames_in_flight(LatencyPolicy::smooth) <= constants::MAX_FRAMES_IN_FLIGHT);
+} // av
+
+#endif //AUDIO_VISUALIZER_LATENCYPOLICY_HPP
@@ -0,0 +1,58 @@
+#ifndef AUDIO_VISUALIZER_LAYOUT_HPP
+#define AUDIO_VISUALIZER_LAYOUT_HPP
+
+#include "MagnitudeEncoding.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+
+namespace av {
+	// arbitrary mesh of Vertex, drawn with VertexBuffer
+	// the indices are 16-bit if every vertex fits, 32-bit otherwise
+	// every vertex also gets one magnitude
+	struct MeshLayout {
+		size_t num_vertices;
+		size_t num_indices;
+		MagnitudeFormat magnitude_format = MagnitudeFormat::float32;
+	};
+
+	// one instanced quad per frequency, drawn with InstanceBuffer
+	// only the magnitudes are uploaded, the shader places and colors each bar from gl_InstanceIndex
+	struct BarLayout {
+		uint32_t num_bars;
+		uint32_t bars_per_octave;
+		MagnitudeFormat magnitude_format = MagnitudeFormat::float32;
+	};
+
+	// scrolling spectrogram of the last num_rows analysis frames, drawn with SpectrogramImage
+	struct SpectrogramLayout {
+		uint32_t num_bins;
+		uint32_t bins_per_octave;
+		uint32_t num_rows;
+		MagnitudeFormat magnitude_format = MagnitudeFormat::float32;
+	};
+
+	// only the strongest local maxima of the spectrum, drawn with PeakBuffer
+	// at most max_peaks are uploaded per frame, so num_bins can be much larger than in BarLayout
+	struct PeakLayout {
+		uint32_t max_peaks;
+		uint32_t num_bins;
+		uint32_t bins_per_octave;
+	};
+
+	// a grid of num_channels bar spectra, drawn with DashboardBuffer in a single draw call
+	// the magnitudes of every channel are packed into one buffer, channel after channel
+	// 0 columns picks the squarest grid that fits
+	struct DashboardLayout {
+		uint32_t num_channels;
+		uint32_t num_bars; // per channel
+		uint32_t bars_per_octave;
+		uint32_t columns = 0;
+		MagnitudeFormat magnitude_format = MagnitudeFormat::float32;
+	};
+
+	using Layout = std::variant<MeshLayout, BarLayout, SpectrogramLayout, PeakLayout, DashboardLayout>;
+} // av
+
+#endif //AUDIO_VISUALIZER_LAYOUT_HPP
@@ -0,0 +1,24 @@
+#ifndef AUDIO_VISUALIZER_LOGQUANTIZATION_HPP
+#define AUDIO_VISUALIZER_LOGQUANTIZATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// maps magnitudes (powers, so 1 is 0 db) from floor_db..0 db linearly onto 0..max_value
+// used by the network output and the recording format
+namespace av::log_quantization {
+	inline uint32_t quantize(float magnitude, float floor_db, uint32_t max_value) {
+		if (!(magnitude > 0.0f)) return 0;
+		float normalized = (10.0f * std::log10(magnitude) - floor_db) / -floor_db;
+		return static_cast<uint32_t>(std::lround(std::clamp(normalized, 0.0f, 1.0f) * max_value));
+	}
+
+	// 0 decodes to exactly 0 instead of the floor, so silence stays silent
+	inline float dequantize(uint32_t value, float floor_db, uint32_t max_value) {
+		if (!value) return 0.0f;
+		return std::pow(10.0f, (static_cast<float>(value) / max_value * -floor_db + floor_db) / 10.0f);
+	}
+} // av
+
+#endif //AUDIO_VISUALIZER_LOGQUANTIZATION_HPP
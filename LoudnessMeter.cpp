@@ -0,0 +1,220 @@
+#include "LoudnessMeter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <tuple>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace av {
+	namespace {
+		// just enough of a 4-lane vector type for the filters, one channel per lane
+#if defined(__SSE2__)
+		using Lanes = __m128;
+		Lanes load(std::array<float, 4> const &x) { return _mm_load_ps(x.data()); }
+		void store(std::array<float, 4> &x, Lanes y) { _mm_store_ps(x.data(), y); }
+		Lanes splat(float x) { return _mm_set1_ps(x); }
+		Lanes add(Lanes x, Lanes y) { return _mm_add_ps(x, y); }
+		Lanes sub(Lanes x, Lanes y) { return _mm_sub_ps(x, y); }
+		Lanes mul(Lanes x, Lanes y) { return _mm_mul_ps(x, y); }
+		Lanes max(Lanes x, Lanes y) { return _mm_max_ps(x, y); }
+		Lanes abs(Lanes x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x); }
+		// zero out anything tiny, the filters would otherwise decay into denormals during silence
+		Lanes flush(Lanes x) { return _mm_and_ps(x, _mm_cmpgt_ps(abs(x), _mm_set1_ps(1e-15f))); }
+#else
+		using Lanes = std::array<float, 4>;
+		template<typename F>
+		Lanes map(Lanes const &x, Lanes const &y, F f) { return {f(x[0], y[0]), f(x[1], y[1]), f(x[2], y[2]), f(x[3], y[3])}; }
+		Lanes load(std::array<float, 4> const &x) { return x; }
+		void store(std::array<float, 4> &x, Lanes y) { x = y; }
+		Lanes splat(float x) { return {x, x, x, x}; }
+		Lanes add(Lanes x, Lanes y) { return map(x, y, [](float a, float b) { return a + b; }); }
+		Lanes sub(Lanes x, Lanes y) { return map(x, y, [](float a, float b) { return a - b; }); }
+		Lanes mul(Lanes x, Lanes y) { return map(x, y, [](float a, float b) { return a * b; }); }
+		Lanes max(Lanes x, Lanes y) { return map(x, y, [](float a, float b) { return std::max(a, b); }); }
+		Lanes abs(Lanes x) { return map(x, x, [](float a, float) { return std::abs(a); }); }
+		Lanes flush(Lanes x) { return map(x, x, [](float a, float) { return std::abs(a) > 1e-15f ? a : 0.0f; }); }
+#endif
+
+		// bs.1770 k-weighting for any sample rate, the coefficients in the spec are only for 48 khz
+		// (same derivation as libebur128)
+		std::array<float, 5> high_shelf(float sample_rate) {
+			double k = std::tan(std::numbers::pi * 1681.974450955533 / sample_rate);
+			double q = 0.7071752369554196;
+			double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+			double vb = std::pow(vh, 0.4996667741545416);
+			double a0 = 1.0 + k / q + k * k;
+			return {
+				static_cast<float>((vh + vb * k / q + k * k) / a0),
+				static_cast<float>(2.0 * (k * k - vh) / a0),
+				static_cast<float>((vh - vb * k / q + k * k) / a0),
+				static_cast<float>(2.0 * (k * k - 1.0) / a0),
+				static_cast<float>((1.0 - k / q + k * k) / a0),
+			};
+		}
+
+		std::array<float, 5> high_pass(float sample_rate) {
+			double k = std::tan(std::numbers::pi * 38.13547087602444 / sample_rate);
+			double q = 0.5003270373238773;
+			double a0 = 1.0 + k / q + k * k;
+			return {
+				1.0f, -2.0f, 1.0f,
+				static_cast<float>(2.0 * (k * k - 1.0) / a0),
+				static_cast<float>((1.0 - k / q + k * k) / a0),
+			};
+		}
+
+		float to_lufs(double energy) {
+			return energy > 0.0 ? static_cast<float>(-0.691 + 10.0 * std::log10(energy))
+			                    : -std::numeric_limits<float>::infinity();
+		}
+	}
+
+	LoudnessMeter::LoudnessMeter(float sample_rate, size_t num_channels)
+		: num_channels{num_channels}
+		, sub_block_size{static_cast<size_t>(std::lround(sample_rate / 10.0f))}
+		, k_weighting{
+			std::apply([](auto... c) { return Biquad{c...}; }, high_shelf(sample_rate)),
+			std::apply([](auto... c) { return Biquad{c...}; }, high_pass(sample_rate)),
+		}
+		, groups((num_channels + LANES - 1) / LANES)
+		, chunk(CHUNK_FRAMES * groups.size())
+		, momentary{-std::numeric_limits<float>::infinity()}
+		, short_term{-std::numeric_limits<float>::infinity()}
+		, integrated{-std::numeric_limits<float>::infinity()}
+		, true_peak{-std::numeric_limits<float>::infinity()} {
+		if (!num_channels)
+			throw std::invalid_argument("the loudness meter needs at least one channel");
+		if (!sub_block_size)
+			throw std::invalid_argument("the sample rate is too low for the loudness meter");
+		// hann windowed sinc at the original nyquist frequency, split into one polyphase branch per output phase
+		constexpr size_t num_taps = TRUE_PEAK_PHASES * TRUE_PEAK_TAPS;
+		for (size_t i = 0; i < num_taps; ++i) {
+			double t = (static_cast<double>(i) - (num_taps - 1) / 2.0) / TRUE_PEAK_PHASES;
+			double sinc = t == 0.0 ? 1.0 : std::sin(std::numbers::pi * t) / (std::numbers::pi * t);
+			double window = 0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * (i + 0.5) / num_taps);
+			// reversed within each branch, so it lines up with the oldest-first history
+			true_peak_filter[i % TRUE_PEAK_PHASES][TRUE_PEAK_TAPS - 1 - i / TRUE_PEAK_PHASES] =
+				static_cast<float>(sinc * window);
+		}
+	}
+
+	void LoudnessMeter::process(float const *interleaved_frames, size_t num_frames) noexcept {
+		while (num_frames) {
+			// chunks never straddle a sub-block
+			size_t frames = std::min({num_frames, CHUNK_FRAMES, sub_block_size - sub_block_frames});
+			process_chunk(interleaved_frames, frames);
+			interleaved_frames += frames * num_channels;
+			num_frames -= frames;
+			if ((sub_block_frames += frames) == sub_block_size)
+				end_sub_block();
+		}
+	}
+
+	void LoudnessMeter::process_chunk(float const *interleaved_frames, size_t num_frames) {
+		size_t const num_groups = groups.size();
+		for (size_t frame = 0; frame < num_frames; ++frame)
+			for (size_t channel = 0; channel < num_groups * LANES; ++channel)
+				chunk[frame * num_groups + channel / LANES][channel % LANES] =
+					channel < num_channels ? interleaved_frames[frame * num_channels + channel] : 0.0f;
+
+		Biquad const &shelf = k_weighting[0], &high_pass = k_weighting[1];
+		Lanes const shelf_b0 = splat(shelf.b0), shelf_b1 = splat(shelf.b1), shelf_b2 = splat(shelf.b2);
+		Lanes const shelf_a1 = splat(shelf.a1), shelf_a2 = splat(shelf.a2);
+		Lanes const high_pass_a1 = splat(high_pass.a1), high_pass_a2 = splat(high_pass.a2);
+		size_t position = history_position;
+		for (size_t g = 0; g < num_groups; ++g) {
+			Group &group = groups[g];
+			// the filter states stay in registers for the whole chunk
+			Lanes s0 = load(group.biquad_state[0]), s1 = load(group.biquad_state[1]);
+			Lanes s2 = load(group.biquad_state[2]), s3 = load(group.biquad_state[3]);
+			Lanes energy = load(group.energy), peak = load(group.peak);
+			position = history_position;
+			for (size_t frame = 0; frame < num_frames; ++frame) {
+				Lanes x = load(chunk[frame * num_groups + g]);
+				// transposed direct form ii, twice
+				Lanes y = add(mul(shelf_b0, x), s0);
+				s0 = add(sub(mul(shelf_b1, x), mul(shelf_a1, y)), s1);
+				s1 = sub(mul(shelf_b2, x), mul(shelf_a2, y));
+				Lanes z = add(y, s2); // the high-pass has b = {1, -2, 1}
+				s2 = sub(sub(s3, add(y, y)), mul(high_pass_a1, z));
+				s3 = sub(y, mul(high_pass_a2, z));
+				energy = add(energy, mul(z, z));
+
+				store(group.history[position], x);
+				store(group.history[position + TRUE_PEAK_TAPS], x);
+				position = (position + 1) % TRUE_PEAK_TAPS;
+				peak = max(peak, abs(x));
+				for (auto const &branch : true_peak_filter) {
+					Lanes interpolated = splat(0.0f);
+					for (size_t tap = 0; tap < TRUE_PEAK_TAPS; ++tap)
+						interpolated = add(interpolated, mul(splat(branch[tap]), load(group.history[position + tap])));
+					peak = max(peak, abs(interpolated));
+				}
+			}
+			store(group.biquad_state[0], flush(s0));
+			store(group.biquad_state[1], flush(s1));
+			store(group.biquad_state[2], flush(s2));
+			store(group.biquad_state[3], flush(s3));
+			store(group.energy, energy);
+			store(group.peak, peak);
+		}
+		history_position = position;
+	}
+
+	void LoudnessMeter::end_sub_block() {
+		double energy = 0.0;
+		for (Group &group : groups) {
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				energy += group.energy[lane];
+				peak = std::max(peak, static_cast<double>(group.peak[lane]));
+			}
+			group.energy = {};
+		}
+		sub_block_energies[num_sub_blocks++ % SHORT_TERM_SUB_BLOCKS] = energy / static_cast<double>(sub_block_size);
+		sub_block_frames = 0;
+
+		auto mean_of_last = [&](size_t n) {
+			double sum = 0.0;
+			for (size_t i = 1; i <= n; ++i)
+				sum += sub_block_energies[(num_sub_blocks - i) % SHORT_TERM_SUB_BLOCKS];
+			return sum / static_cast<double>(n);
+		};
+		double block_energy = mean_of_last(MOMENTARY_SUB_BLOCKS); // 400 ms gating blocks overlap by 75%
+		float block_loudness = to_lufs(block_energy);
+		momentary.store(block_loudness, std::memory_order_relaxed);
+		short_term.store(to_lufs(mean_of_last(SHORT_TERM_SUB_BLOCKS)), std::memory_order_relaxed);
+		true_peak.store(static_cast<float>(20.0 * std::log10(peak)), std::memory_order_relaxed);
+
+		if (num_sub_blocks < MOMENTARY_SUB_BLOCKS || !(block_loudness > -70.0f)) return; // absolute gate
+		auto bin_of = [](float loudness) {
+			return std::clamp<ptrdiff_t>(static_cast<ptrdiff_t>((loudness + 70.0f) * 10.0f), 0, HISTOGRAM_BINS - 1);
+		};
+		++histogram_counts[bin_of(block_loudness)];
+		histogram_energies[bin_of(block_loudness)] += block_energy;
+		// relative gate, to the nearest 0.1 lu
+		double sum = 0.0;
+		uint64_t count = 0;
+		for (size_t bin = 0; bin < HISTOGRAM_BINS; ++bin)
+			sum += histogram_energies[bin], count += histogram_counts[bin];
+		auto gate = static_cast<size_t>(bin_of(to_lufs(sum / static_cast<double>(count)) - 10.0f));
+		sum = 0.0, count = 0;
+		for (size_t bin = gate; bin < HISTOGRAM_BINS; ++bin)
+			sum += histogram_energies[bin], count += histogram_counts[bin];
+		integrated.store(to_lufs(sum / static_cast<double>(count)), std::memory_order_relaxed);
+	}
+
+	LoudnessMeter::Readings LoudnessMeter::readings() const noexcept {
+		return {
+			.momentary = momentary.load(std::memory_order_relaxed),
+			.short_term = short_term.load(std::memory_order_relaxed),
+			.integrated = integrated.load(std::memory_order_relaxed),
+			.true_peak = true_peak.load(std::memory_order_relaxed),
+		};
+	}
+} // av
@@ -0,0 +1,78 @@
+#ifndef AUDIO_VISUALIZER_LOUDNESSMETER_HPP
+#define AUDIO_VISUALIZER_LOUDNESSMETER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace av {
+	// itu-r bs.1770 / ebu r128 loudness of an interleaved multichannel stream
+	// process() runs on the capture thread for every block, readings() can be called from anywhere
+	// the channels are processed 4 at a time in simd lanes, and every channel is weighted 1
+	// (the channel map isn't known, so surround channels don't get their 1.41 and the lfe isn't dropped)
+	class LoudnessMeter {
+	public:
+		struct Readings {
+			float momentary; // lufs over the last 400 ms
+			float short_term; // lufs over the last 3 s
+			float integrated; // lufs since construction, with the -70 lufs absolute and -10 lu relative gates
+			float true_peak; // dbtp since construction, 4x oversampled, max over the channels
+		};
+
+		LoudnessMeter(float sample_rate, size_t num_channels);
+
+		// never allocates or locks
+		void process(float const *interleaved_frames, size_t num_frames) noexcept;
+
+		// each value is read atomically on its own, so they can be up to 100 ms apart
+		[[nodiscard]] Readings readings() const noexcept;
+
+		size_t const num_channels;
+
+	private:
+		static constexpr size_t LANES = 4;
+		static constexpr size_t CHUNK_FRAMES = 256;
+		static constexpr size_t TRUE_PEAK_PHASES = 4;
+		static constexpr size_t TRUE_PEAK_TAPS = 12; // per phase
+		static constexpr size_t SHORT_TERM_SUB_BLOCKS = 30; // of 100 ms
+		static constexpr size_t MOMENTARY_SUB_BLOCKS = 4;
+		static constexpr size_t HISTOGRAM_BINS = 1000; // 0.1 lu each, from -70 lufs
+		struct Biquad {
+			float b0, b1, b2, a1, a2;
+		};
+		// one set of lanes, LANES channels
+		struct alignas(16) Group {
+			std::array<std::array<float, LANES>, 4> biquad_state{}; // two per stage
+			std::array<float, LANES> energy{};
+			std::array<float, LANES> peak{};
+			// every sample is written twice so the last TRUE_PEAK_TAPS are always contiguous
+			std::array<std::array<float, LANES>, 2 * TRUE_PEAK_TAPS> history{};
+		};
+
+		size_t const sub_block_size; // 100 ms of frames
+		std::array<Biquad, 2> const k_weighting; // shelf, then high-pass
+		std::array<std::array<float, TRUE_PEAK_TAPS>, TRUE_PEAK_PHASES> true_peak_filter;
+		std::vector<Group> groups;
+		std::vector<std::array<float, LANES>> chunk; // the current chunk, deinterleaved into lanes
+		size_t history_position = 0;
+		size_t sub_block_frames = 0;
+		std::array<double, SHORT_TERM_SUB_BLOCKS> sub_block_energies{};
+		uint64_t num_sub_blocks = 0;
+		// gating blocks by loudness, with their energies, so the integrated loudness never needs the whole history
+		std::array<uint64_t, HISTOGRAM_BINS> histogram_counts{};
+		std::array<double, HISTOGRAM_BINS> histogram_energies{};
+		double peak = 0.0;
+
+		std::atomic<float> momentary;
+		std::atomic<float> short_term;
+		std::atomic<float> integrated;
+		std::atomic<float> true_peak;
+
+		void process_chunk(float const *interleaved_frames, size_t num_frames);
+		void end_sub_block();
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_LOUDNESSMETER_HPP
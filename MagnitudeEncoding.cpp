@@ -0,0 +1,123 @@
+#include "MagnitudeEncoding.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// the log is the expensive part, so it's done with a few multiplies instead of std::log10
+// 4 lanes at a time with sse2 (always there on x86-64), the same math one at a time everywhere else
+
+namespace av {
+	namespace {
+		constexpr float TINY = 1e-30f; // keeps the log finite for zeros, denormals and nans
+		constexpr float LN_2 = 0.693147180559945f;
+		// 1 + log2(x) * SCALE is the encoded value
+		constexpr float SCALE = 10.0f * 0.301029995663981f / -MAGNITUDE_FLOOR_DB;
+
+		constexpr int32_t SQRT_HALF_BITS = 0x3f3504f3;
+		constexpr float HALF_MIN = 6.103515625e-05f; // smallest normal float16, anything below becomes 0
+
+		// x = 2^e * m with m in [sqrt(1/2), sqrt(2)), then ln(m) = 2 atanh(t) with t = (m - 1) / (m + 1)
+		// |t| < 0.172, so four terms of the series are accurate to about 1e-7
+		float encode(float magnitude) {
+			float x = std::max(magnitude, TINY);
+			if (std::isnan(magnitude)) x = TINY;
+			auto bits = std::bit_cast<int32_t>(x);
+			int32_t e = (bits - SQRT_HALF_BITS) >> 23;
+			float m = std::bit_cast<float>(bits - (e << 23));
+			float t = (m - 1.0f) / (m + 1.0f), t2 = t * t;
+			float ln_m = 2.0f * t * (1.0f + t2 * (1.0f / 3.0f + t2 * (1.0f / 5.0f + t2 * (1.0f / 7.0f))));
+			float log2_x = static_cast<float>(e) + ln_m / LN_2;
+			return std::clamp(1.0f + log2_x * SCALE, 0.0f, 1.0f);
+		}
+
+		// only for values in [0, 1], rounds to nearest even
+		uint16_t to_half(float value) {
+			if (value < HALF_MIN) return 0;
+			auto bits = std::bit_cast<uint32_t>(value);
+			return static_cast<uint16_t>(((bits + 0xfff + ((bits >> 13) & 1)) >> 13) - (112 << 10));
+		}
+
+		uint8_t to_unorm8(float value) {
+			return static_cast<uint8_t>(std::lrint(value * 255.0f));
+		}
+
+#if defined(__SSE2__)
+		__m128 encode(__m128 magnitude) {
+			__m128 x = _mm_max_ps(magnitude, _mm_set1_ps(TINY)); // returns the second operand for nans
+			__m128i bits = _mm_castps_si128(x);
+			__m128i e = _mm_srai_epi32(_mm_sub_epi32(bits, _mm_set1_epi32(SQRT_HALF_BITS)), 23);
+			__m128 m = _mm_castsi128_ps(_mm_sub_epi32(bits, _mm_slli_epi32(e, 23)));
+			__m128 one = _mm_set1_ps(1.0f);
+			__m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+			__m128 t2 = _mm_mul_ps(t, t);
+			__m128 series = _mm_add_ps(_mm_set1_ps(1.0f / 5.0f), _mm_mul_ps(t2, _mm_set1_ps(1.0f / 7.0f)));
+			series = _mm_add_ps(_mm_set1_ps(1.0f / 3.0f), _mm_mul_ps(t2, series));
+			series = _mm_add_ps(one, _mm_mul_ps(t2, series));
+			__m128 ln_m = _mm_mul_ps(_mm_add_ps(t, t), series);
+			__m128 log2_x = _mm_add_ps(_mm_cvtepi32_ps(e), _mm_mul_ps(ln_m, _mm_set1_ps(1.0f / LN_2)));
+			__m128 encoded = _mm_add_ps(one, _mm_mul_ps(log2_x, _mm_set1_ps(SCALE)));
+			return _mm_min_ps(_mm_max_ps(encoded, _mm_setzero_ps()), one);
+		}
+
+		__m128i to_half(__m128 value) {
+			__m128i bits = _mm_castps_si128(value);
+			__m128i round = _mm_add_epi32(
+				_mm_set1_epi32(0xfff), _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1)));
+			__m128i half = _mm_sub_epi32(_mm_srli_epi32(_mm_add_epi32(bits, round), 13), _mm_set1_epi32(112 << 10));
+			__m128i normal = _mm_castps_si128(_mm_cmpge_ps(value, _mm_set1_ps(HALF_MIN)));
+			return _mm_and_si128(half, normal);
+		}
+#endif
+	}
+
+	void encode_magnitudes(std::span<float const> magnitudes, MagnitudeFormat format, std::span<std::byte> encoded) {
+		if (encoded.size() < magnitudes.size() * magnitude_size(format))
+			throw std::length_error("not enough room for the encoded magnitudes");
+		float const *in = magnitudes.data();
+		std::byte *out = encoded.data();
+		size_t i = 0;
+#if defined(__SSE2__)
+		for (; i + 4 <= magnitudes.size(); i += 4) {
+			__m128 value = encode(_mm_loadu_ps(in + i));
+			switch (format) {
+				case MagnitudeFormat::float16: // at most 0x3c00, so the signed saturating pack is exact
+					_mm_storel_epi64(
+						reinterpret_cast<__m128i *>(out + i * 2), _mm_packs_epi32(to_half(value), _mm_setzero_si128()));
+					break;
+				case MagnitudeFormat::unorm8: {
+					__m128i words = _mm_packs_epi32(
+						_mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(255.0f))), _mm_setzero_si128());
+					int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, _mm_setzero_si128()));
+					std::memcpy(out + i, &bytes, sizeof(bytes));
+					break;
+				}
+				default:
+					_mm_storeu_ps(reinterpret_cast<float *>(out + i * 4), value);
+			}
+		}
+#endif
+		for (; i < magnitudes.size(); ++i) {
+			float value = encode(in[i]);
+			switch (format) {
+				case MagnitudeFormat::float16: {
+					uint16_t half = to_half(value);
+					std::memcpy(out + i * 2, &half, sizeof(half));
+					break;
+				}
+				case MagnitudeFormat::unorm8:
+					out[i] = std::byte{to_unorm8(value)};
+					break;
+				default:
+					std::memcpy(out + i * 4, &value, sizeof(value));
+			}
+		}
+	}
+} // av
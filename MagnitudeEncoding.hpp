@@ -0,0 +1,49 @@
+#ifndef AUDIO_VISUALIZER_MAGNITUDEENCODING_HPP
+#define AUDIO_VISUALIZER_MAGNITUDEENCODING_HPP
+
+#include "graphics_headers.hpp"
+#include <cstddef>
+#include <span>
+
+namespace av {
+	// how the per-frame magnitudes are stored in gpu memory
+	// every format holds the same log encoding, 1 + db / -MAGNITUDE_FLOOR_DB clamped to [0, 1],
+	// so the shaders decode all of them the same way and the narrow ones lose very little
+	enum class MagnitudeFormat {
+		float32,
+		float16,
+		unorm8,
+	};
+
+	// the quietest magnitude that isn't drawn black, relative to the loudest (which is 1)
+	// the shaders get it as a specialization constant, see shaders/common.glsl
+	static constexpr float MAGNITUDE_FLOOR_DB = -60.0f;
+
+	constexpr size_t magnitude_size(MagnitudeFormat format) {
+		switch (format) {
+			case MagnitudeFormat::float16:
+				return 2;
+			case MagnitudeFormat::unorm8:
+				return 1;
+			default:
+				return 4;
+		}
+	}
+
+	constexpr vk::Format magnitude_vk_format(MagnitudeFormat format) {
+		switch (format) {
+			case MagnitudeFormat::float16:
+				return vk::Format::eR16Sfloat;
+			case MagnitudeFormat::unorm8:
+				return vk::Format::eR8Unorm;
+			default:
+				return vk::Format::eR32Sfloat;
+		}
+	}
+
+	// magnitudes are linear powers, normally 0 to 1
+	// encoded must hold magnitudes.size() * magnitude_size(format) bytes
+	void encode_magnitudes(std::span<float const> magnitudes, MagnitudeFormat, std::span<std::byte> encoded);
+} // av
+
+#endif //AUDIO_VISUALIZER_MAGNITUDEENCODING_HPP
@@ -0,0 +1,28 @@
+#include "MagnitudeSlots.hpp"
+
+namespace av {
+	void MagnitudeSlots::commit() {
+		_newest = write();
+	}
+
+	void MagnitudeSlots::mark_drawn(uint64_t frame_value) {
+		_frame_values[newest()] = frame_value;
+		_frame_values[previous()] = frame_value;
+	}
+
+	uint32_t MagnitudeSlots::newest() const {
+		return _newest;
+	}
+
+	uint32_t MagnitudeSlots::previous() const {
+		return (_newest + NUM_SLOTS - 1) % NUM_SLOTS;
+	}
+
+	uint32_t MagnitudeSlots::write() const {
+		return (_newest + 1) % NUM_SLOTS;
+	}
+
+	uint64_t MagnitudeSlots::write_frame_value() const {
+		return _frame_values[write()];
+	}
+} // av
@@ -0,0 +1,33 @@
+#ifndef AUDIO_VISUALIZER_MAGNITUDESLOTS_HPP
+#define AUDIO_VISUALIZER_MAGNITUDESLOTS_HPP
+
+#include "constants.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace av {
+	// a ring of encoded magnitude frames side by side in one buffer
+	// the gpu draws from the newest and the previous slot while the cpu writes the next one,
+	// and frames still in flight may be reading older ones, so every slot remembers the last frame that drew from it
+	class MagnitudeSlots {
+	public:
+		// enough that the slot being written is almost always long finished with
+		static constexpr uint32_t NUM_SLOTS = constants::MAX_FRAMES_IN_FLIGHT + 2;
+		// the write slot becomes the newest
+		void commit();
+		// the frame that signals frame_value on the FrameTimeline was recorded drawing from newest and previous
+		void mark_drawn(uint64_t frame_value);
+		[[nodiscard]] uint32_t newest() const;
+		[[nodiscard]] uint32_t previous() const;
+		[[nodiscard]] uint32_t write() const;
+		// wait for this on the FrameTimeline before writing the write slot
+		[[nodiscard]] uint64_t write_frame_value() const;
+
+	private:
+		uint32_t _newest = NUM_SLOTS - 1; // so the first write goes into slot 0
+		std::array<uint64_t, NUM_SLOTS> _frame_values{};
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_MAGNITUDESLOTS_HPP
@@ -0,0 +1,259 @@
+#include "NetworkSender.hpp"
+
+#include "LogQuantization.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__)
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// binary packet header, everything big-endian:
+//	char magic[4] = "AVSP"
+//	uint8_t version = 1
+//	uint8_t quantization (NetworkOptions::Quantization)
+//	uint8_t flags (bit 0: delta)
+//	uint8_t reserved
+//	uint64_t frame index
+//	int64_t timestamp in nanoseconds (steady_clock of the sender)
+//	uint16_t total number of bins in the frame
+//	uint16_t first bin in this packet
+//	uint16_t number of bins in this packet
+//	uint16_t reserved
+// a frame that doesn't fit in max_packet_size is split into several packets
+
+namespace av {
+	namespace {
+		constexpr uint8_t BINARY_VERSION = 1;
+		constexpr size_t BINARY_HEADER_SIZE = 32;
+		constexpr char OSC_ADDRESS[] = "/av/spectrum";
+		constexpr char OSC_QUANTIZED_ADDRESS[] = "/av/spectrum/quantized";
+
+		size_t osc_padded(size_t size) { return (size + 4) & ~size_t{3}; } // strings always get at least one null
+
+		class PacketWriter {
+		public:
+			std::vector<std::byte> bytes;
+
+			template<typename T>
+			void put(T value) {
+				auto raw = std::bit_cast<std::array<std::byte, sizeof(T)>>(value);
+				if constexpr (std::endian::native == std::endian::little)
+					std::ranges::reverse(raw);
+				bytes.insert(bytes.end(), raw.begin(), raw.end());
+			}
+
+			void put_osc_string(std::string_view string) {
+				size_t begin = bytes.size();
+				for (char c : string) bytes.push_back(std::byte(c));
+				bytes.resize(begin + osc_padded(string.size()));
+			}
+
+			void put_varint(uint32_t value) {
+				for (; value >= 0x80; value >>= 7)
+					bytes.push_back(std::byte(value | 0x80));
+				bytes.push_back(std::byte(value));
+			}
+
+			void pad_to_4() { bytes.resize((bytes.size() + 3) & ~size_t{3}); }
+		};
+
+		uint32_t quantize(float magnitude, NetworkOptions const &options) {
+			uint32_t max_value = options.quantization == NetworkOptions::Quantization::log8 ? 0xff : 0xffff;
+			return log_quantization::quantize(magnitude, options.floor_db, max_value);
+		}
+
+		// appends one bin of payload, the same for the binary format and the quantized osc blob
+		void put_value(PacketWriter &writer, float magnitude, uint32_t &previous, NetworkOptions const &options) {
+			using Quantization = NetworkOptions::Quantization;
+			if (options.quantization == Quantization::none) {
+				writer.put(magnitude);
+				return;
+			}
+			uint32_t value = quantize(magnitude, options);
+			if (options.delta) {
+				auto difference = static_cast<int32_t>(value - previous);
+				writer.put_varint(static_cast<uint32_t>(difference << 1) ^ static_cast<uint32_t>(difference >> 31));
+			} else if (options.quantization == Quantization::log8)
+				writer.put(static_cast<uint8_t>(value));
+			else
+				writer.put(static_cast<uint16_t>(value));
+			previous = value;
+		}
+
+		// bytes around the payload of a packet holding num_values bins
+		size_t overhead(size_t num_values, NetworkOptions const &options) {
+			if (options.encoding == NetworkOptions::Encoding::binary)
+				return BINARY_HEADER_SIZE;
+			if (options.quantization == NetworkOptions::Quantization::none)
+				return osc_padded(std::size(OSC_ADDRESS) - 1) + osc_padded(4 + num_values) + 8 + 8 + 4;
+			return osc_padded(std::size(OSC_QUANTIZED_ADDRESS) - 1) + osc_padded(7) + 8 + 8 + 4 + 4 + 4 + 4 + 3;
+		}
+
+		void put_header(
+			PacketWriter &writer, uint64_t frame_index, int64_t timestamp_nanoseconds, size_t total_bins,
+			size_t first_bin, size_t num_bins, size_t payload_size, NetworkOptions const &options
+		) {
+			auto format = static_cast<uint8_t>(options.quantization);
+			uint8_t flags = options.delta && options.quantization != NetworkOptions::Quantization::none;
+			if (options.encoding == NetworkOptions::Encoding::binary) {
+				for (char c : {'A', 'V', 'S', 'P'}) writer.put(c);
+				writer.put(BINARY_VERSION);
+				writer.put(format);
+				writer.put(flags);
+				writer.put(uint8_t{0});
+				writer.put(frame_index);
+				writer.put(timestamp_nanoseconds);
+				writer.put(static_cast<uint16_t>(total_bins));
+				writer.put(static_cast<uint16_t>(first_bin));
+				writer.put(static_cast<uint16_t>(num_bins));
+				writer.put(uint16_t{0});
+			} else if (options.quantization == NetworkOptions::Quantization::none) {
+				writer.put_osc_string(OSC_ADDRESS);
+				writer.put_osc_string(",hhi" + std::string(num_bins, 'f'));
+				writer.put(frame_index);
+				writer.put(timestamp_nanoseconds);
+				writer.put(static_cast<int32_t>(first_bin));
+			} else {
+				writer.put_osc_string(OSC_QUANTIZED_ADDRESS);
+				writer.put_osc_string(",hhiiib");
+				writer.put(frame_index);
+				writer.put(timestamp_nanoseconds);
+				writer.put(static_cast<int32_t>(first_bin));
+				writer.put(static_cast<int32_t>(num_bins));
+				writer.put(static_cast<int32_t>(format | flags << 8));
+				writer.put(static_cast<int32_t>(payload_size));
+			}
+		}
+
+#if defined(__unix__)
+		bool send_packet(int socket, std::vector<std::byte> const &packet) {
+			return ::send(socket, packet.data(), packet.size(), 0) == static_cast<ssize_t>(packet.size());
+		}
+#else
+		bool send_packet(int, std::vector<std::byte> const &) { return false; }
+#endif
+	}
+
+	NetworkSender::NetworkSender(
+		std::span<NetworkDestination const> destinations, size_t num_bins, NetworkOptions const &options
+	)
+		: options{options}
+		, queue{options.queue_capacity, Frame{0, 0, std::vector<float>(num_bins)}} {
+		if (num_bins > 0xffff)
+			throw std::length_error("the packet formats only have room for 65535 bins");
+		if (overhead(1, options) + 5 > options.max_packet_size)
+			throw std::invalid_argument("max_packet_size is too small to hold a single bin");
+		for (NetworkDestination const &destination : destinations)
+			sockets.emplace_back(create_socket(destination));
+		thread = std::thread(&NetworkSender::run, this);
+	}
+
+	bool NetworkSender::send(int64_t timestamp_nanoseconds, std::span<float const> magnitudes, float gain) noexcept {
+		uint64_t frame_index = next_frame_index++; // counts dropped frames too, so receivers can tell
+		Frame *frame = queue.begin_push();
+		if (!frame) return false;
+		frame->index = frame_index;
+		frame->timestamp_nanoseconds = timestamp_nanoseconds;
+		size_t num_bins = std::min(magnitudes.size(), frame->magnitudes.size());
+		for (size_t i = 0; i < num_bins; ++i)
+			frame->magnitudes[i] = magnitudes[i] * gain;
+		queue.end_push();
+		return true;
+	}
+
+	void NetworkSender::run() {
+		AV_TRACE_THREAD("network");
+		PacketWriter header, payload;
+		bool warned = false;
+		auto flush = [&](Frame const &frame, size_t first_bin, size_t num_bins) {
+			header.bytes.clear();
+			put_header(
+				header, frame.index, frame.timestamp_nanoseconds, frame.magnitudes.size(), first_bin, num_bins,
+				payload.bytes.size(), options
+			);
+			if (options.encoding == NetworkOptions::Encoding::osc
+			    && options.quantization != NetworkOptions::Quantization::none)
+				payload.pad_to_4(); // blob
+			header.bytes.insert(header.bytes.end(), payload.bytes.begin(), payload.bytes.end());
+			payload.bytes.clear();
+			for (int socket : sockets)
+				if (!send_packet(socket, header.bytes) && !warned) {
+					warned = true;
+					std::cerr << "warning: failed to send a spectrum packet: " << std::strerror(errno) << std::endl;
+				}
+		};
+		while (queue.wait_for_push()) {
+			// live data, a stale frame is worth less than the newest one (receivers see the gap in the frame index)
+			queue.skip_to_newest();
+			while (Frame *frame = queue.front()) {
+				AV_TRACE_SCOPE("send");
+				size_t first_bin = 0;
+				uint32_t previous = 0;
+				for (size_t i = 0; i < frame->magnitudes.size(); ++i) {
+					size_t payload_size = payload.bytes.size();
+					put_value(payload, frame->magnitudes[i], previous, options);
+					if (overhead(i + 1 - first_bin, options) + payload.bytes.size() > options.max_packet_size) {
+						payload.bytes.resize(payload_size);
+						flush(*frame, first_bin, i - first_bin);
+						first_bin = i;
+						previous = 0;
+						put_value(payload, frame->magnitudes[i], previous, options);
+					}
+				}
+				flush(*frame, first_bin, frame->magnitudes.size() - first_bin);
+				queue.pop();
+				queue.skip_to_newest(); // whatever arrived while this one was sent
+			}
+		}
+	}
+
+#if defined(__unix__)
+	int NetworkSender::create_socket(NetworkDestination const &destination) {
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_DGRAM;
+		addrinfo *addresses;
+		if (int error = getaddrinfo(destination.host, std::to_string(destination.port).c_str(), &hints, &addresses))
+			throw std::runtime_error(std::string("failed to resolve ") + destination.host + ": " + gai_strerror(error));
+		for (addrinfo *address = addresses; address; address = address->ai_next) {
+			int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+			if (fd == -1) continue;
+			if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+				freeaddrinfo(addresses);
+				return fd;
+			}
+			close(fd);
+		}
+		freeaddrinfo(addresses);
+		throw std::runtime_error(std::string("failed to create a udp socket for ") + destination.host);
+	}
+
+	NetworkSender::~NetworkSender() {
+		queue.close();
+		thread.join();
+		for (int socket : sockets)
+			close(socket);
+	}
+#else
+	int NetworkSender::create_socket(NetworkDestination const &) {
+		throw std::runtime_error("network output needs posix sockets");
+	}
+
+	NetworkSender::~NetworkSender() {
+		queue.close();
+		thread.join();
+	}
+#endif
+} // av
@@ -0,0 +1,78 @@
+#ifndef AUDIO_VISUALIZER_NETWORKSENDER_HPP
+#define AUDIO_VISUALIZER_NETWORKSENDER_HPP
+
+#include "SpscQueue.hpp"
+
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace av {
+	struct NetworkDestination {
+		char const *host;
+		uint16_t port;
+	};
+
+	struct NetworkOptions {
+		enum class Encoding {
+			// /av/spectrum ,hhi f... (frame index, timestamp, first bin, magnitudes)
+			// /av/spectrum/quantized ,hhiiib (frame index, timestamp, first bin, bin count, format, payload)
+			osc,
+			// 32 byte header (see NetworkSender.cpp) followed by the same payload as the quantized osc blob
+			binary,
+		};
+		enum class Quantization : uint8_t {
+			none = 0, // big-endian floats
+			log8 = 1,
+			log16 = 2,
+		};
+		Encoding encoding = Encoding::osc;
+		// log quantization maps floor_db..0 db linearly onto the integer range
+		// (magnitudes are powers, so 1 is 0 db and 10 * log10 is used)
+		Quantization quantization = Quantization::none;
+		float floor_db = -60.0f;
+		// only with quantization: each value is the difference to the previous bin as a zigzag varint,
+		// the first bin of every packet is relative to 0 so a lost packet doesn't break the others
+		bool delta = false;
+		size_t max_packet_size = 1472; // udp payload that fits a 1500 byte ethernet mtu
+		// frames waiting to be sent, a sender that falls behind skips the older ones and sends the newest
+		// send() only drops a frame if all of them are still waiting because a single frame took that long
+		size_t queue_capacity = 8;
+	};
+
+	// streams spectral frames over udp from its own thread
+	// send() only copies into a lock-free queue, so the render loop never touches a socket
+	class NetworkSender {
+	public:
+		NetworkSender(std::span<NetworkDestination const>, size_t num_bins, NetworkOptions const &);
+
+		~NetworkSender();
+
+		NetworkSender(NetworkSender const &) = delete;
+		NetworkSender &operator=(NetworkSender const &) = delete;
+
+		// every magnitude is multiplied by gain on the way into the queue (e.g. to normalize)
+		// false if the queue was full and the frame got dropped
+		bool send(int64_t timestamp_nanoseconds, std::span<float const> magnitudes, float gain = 1.0f) noexcept;
+
+	private:
+		struct Frame {
+			uint64_t index;
+			int64_t timestamp_nanoseconds;
+			std::vector<float> magnitudes;
+		};
+
+		NetworkOptions const options;
+		std::vector<int> sockets; // one connected udp socket per destination
+		SpscQueue<Frame> queue;
+		uint64_t next_frame_index = 0;
+		std::thread thread;
+
+		static int create_socket(NetworkDestination const &);
+
+		void run();
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_NETWORKSENDER_HPP
@@ -0,0 +1,166 @@
+#include "Output.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <variant>
+
+namespace av {
+	Output::Output(
+		Window &window,
+		Layout const &layout,
+		Gpu const &gpu,
+		LatencyPolicy latency_policy,
+		UploadStrategy upload_strategy
+	)
+		: window{check_present_support(window, gpu)}
+		, frames{get_frames_in_flight(latency_policy), gpu}
+		, _geometry{create_geometry(layout, gpu, upload_strategy)}
+		, _state{window.surface, gpu, window->getFramebufferSize(), get_pipeline_description(_geometry), latency_policy} {}
+
+	bool Output::resize(Gpu const &gpu, FrameTimeline const &frame_timeline) {
+		auto [width, height] = window->getFramebufferSize();
+		if (!width || !height) { // minimized, try again next frame
+			window.framebuffer_resized = true;
+			return false;
+		}
+		uint64_t last_value = 0;
+		for (size_t i = 0; i < frames.size(); ++i)
+			last_value = std::max(last_value, frames[i].timeline_value);
+		if (!frame_timeline.wait(last_value, constants::FRAME_TIMEOUT_NANOSECONDS))
+			throw std::runtime_error("Vulkan frame did not finish in time");
+		_state.recreate(window.surface, gpu, window->getFramebufferSize());
+		window.framebuffer_resized = false;
+		return true;
+	}
+
+	void Output::commit_magnitudes() {
+		std::visit([](auto &alternative) {
+			if constexpr (requires { alternative.commit_magnitudes(); })
+				alternative.commit_magnitudes();
+		}, _geometry);
+	}
+
+	uint64_t Output::write_frame_value() const {
+		return std::visit([](auto const &alternative) -> uint64_t {
+			if constexpr (requires { alternative.write_frame_value(); })
+				return alternative.write_frame_value();
+			return 0;
+		}, _geometry);
+	}
+
+	void Output::mark_drawn(uint64_t frame_value) {
+		std::visit([frame_value](auto &alternative) {
+			if constexpr (requires { alternative.mark_drawn(frame_value); })
+				alternative.mark_drawn(frame_value);
+		}, _geometry);
+	}
+
+	void Output::set_blend(float blend) {
+		std::visit([blend](auto &alternative) {
+			if constexpr (requires { alternative.set_blend(blend); })
+				alternative.set_blend(blend);
+		}, _geometry);
+	}
+
+	size_t Output::queue_depth() const {
+		return get_queue_depth(_state.surface_info.present_mode, _state.framebuffers.size(), frames.size());
+	}
+
+	UploadBuffer const *Output::get_upload_buffer() const {
+		return std::visit([](auto const &alternative) -> UploadBuffer const * {
+			if constexpr (requires { alternative.upload_buffer; })
+				return &alternative.upload_buffer;
+			return nullptr;
+		}, _geometry);
+	}
+
+	void Output::record_command_buffer(
+		Frame const &frame,
+		vk::raii::Framebuffer const &framebuffer,
+		uint32_t flight_frame,
+		bool upload
+	) {
+		vk::raii::CommandBuffer const &command_buffer = frame.command_buffer;
+		command_buffer.reset({});
+		command_buffer.begin({});
+		// transfers have to happen outside of the render pass
+		std::visit([&](auto &alternative) {
+			if constexpr (requires { alternative.record_upload(command_buffer, flight_frame); })
+				alternative.record_upload(command_buffer, flight_frame);
+		}, _geometry);
+		if (UploadBuffer const *upload_buffer = get_upload_buffer(); upload_buffer && upload)
+			upload_buffer->record_upload(command_buffer, flight_frame);
+		if (*frame.timestamp_query_pool) {
+			command_buffer.resetQueryPool(*frame.timestamp_query_pool, 0, 2);
+			command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *frame.timestamp_query_pool, 0);
+		}
+		{
+			vk::ClearValue clear_value{.color{.float32 = std::array{0.0f, 0.0f, 0.0f, 1.0f}}};
+			vk::RenderPassBeginInfo render_pass_begin_info{
+				.renderPass = *_state.render_pass,
+				.framebuffer = *framebuffer,
+				.renderArea{
+					.offset{.x=0, .y=0},
+					.extent = _state.surface_info.extent,
+				},
+				.clearValueCount = 1,
+				.pClearValues = &clear_value,
+			};
+			command_buffer.beginRenderPass(render_pass_begin_info, vk::SubpassContents::eInline);
+			{
+				command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *_state.pipeline);
+				std::visit([&](auto const &alternative) {
+					alternative.bind_and_draw(command_buffer, _state.pipeline_layout);
+				}, _geometry);
+			}
+			command_buffer.endRenderPass();
+		}
+		if (*frame.timestamp_query_pool)
+			command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *frame.timestamp_query_pool, 1);
+		command_buffer.end();
+	}
+
+	void Output::record_transfer_command_buffer(Frame const &frame, uint32_t flight_frame) const {
+		vk::raii::CommandBuffer const &command_buffer = frame.transfer_command_buffer;
+		command_buffer.reset({});
+		command_buffer.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+		get_upload_buffer()->record_transfer(command_buffer, flight_frame);
+		command_buffer.end();
+	}
+
+	// the gpu was chosen for the first window, the present queue has to reach the others too
+	Window &Output::check_present_support(Window &window, Gpu const &gpu) {
+		if (!gpu.physical_device.getSurfaceSupportKHR(gpu.queue_family_indices.present, *window.surface))
+			throw std::runtime_error("the present queue can't present to every window");
+		return window;
+	}
+
+	// the alternatives aren't movable, so they have to be constructed in place
+	Geometry Output::create_geometry(Layout const &layout, Gpu const &gpu, UploadStrategy upload_strategy) {
+		if (auto const *mesh_layout = std::get_if<MeshLayout>(&layout)) {
+			if (mesh_layout->num_vertices <= VertexBuffer<uint16_t>::MAX_VERTICES)
+				return Geometry{
+					std::in_place_type<VertexBuffer<uint16_t>>, *mesh_layout, gpu, gpu.allocator, upload_strategy
+				};
+			return Geometry{
+				std::in_place_type<VertexBuffer<uint32_t>>, *mesh_layout, gpu, gpu.allocator, upload_strategy
+			};
+		}
+		if (auto const *bar_layout = std::get_if<BarLayout>(&layout))
+			return Geometry{std::in_place_type<InstanceBuffer>, *bar_layout, gpu, gpu.allocator, upload_strategy};
+		if (auto const *spectrogram_layout = std::get_if<SpectrogramLayout>(&layout))
+			return Geometry{std::in_place_type<SpectrogramImage>, *spectrogram_layout, gpu, gpu.allocator};
+		if (auto const *dashboard_layout = std::get_if<DashboardLayout>(&layout))
+			return Geometry{std::in_place_type<DashboardBuffer>, *dashboard_layout, gpu, gpu.allocator, upload_strategy};
+		return Geometry{
+			std::in_place_type<PeakBuffer>, std::get<PeakLayout>(layout), gpu, gpu.allocator, upload_strategy
+		};
+	}
+
+	PipelineDescription const &Output::get_pipeline_description(Geometry const &geometry) {
+		return std::visit([](auto const &alternative) -> PipelineDescription const & {
+			return alternative.pipeline_description;
+		}, geometry);
+	}
+} // av
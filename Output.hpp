@@ -0,0 +1,68 @@
+#ifndef AUDIO_VISUALIZER_OUTPUT_HPP
+#define AUDIO_VISUALIZER_OUTPUT_HPP
+
+#include "Window.hpp"
+#include "DashboardBuffer.hpp"
+#include "Gpu.hpp"
+#include "GraphicsState.hpp"
+#include "VertexBuffer.hpp"
+#include "InstanceBuffer.hpp"
+#include "SpectrogramImage.hpp"
+#include "Frame.hpp"
+#include "FrameTimeline.hpp"
+#include "Layout.hpp"
+#include "LatencyPolicy.hpp"
+#include "PeakBuffer.hpp"
+#include "UploadBuffer.hpp"
+#include "graphics_headers.hpp"
+#include <variant>
+
+namespace av {
+	// one alternative per Layout alternative
+	using Geometry = std::variant<
+		VertexBuffer<uint16_t>, VertexBuffer<uint32_t>, InstanceBuffer, SpectrogramImage, PeakBuffer, DashboardBuffer
+	>;
+
+	// one window of a Renderer, with its own swapchain, layout and frames in flight
+	// the device, the frame timeline, the submit and the present are shared with the other outputs
+	class Output {
+	public:
+		Output(Window &, Layout const &, Gpu const &, LatencyPolicy, UploadStrategy);
+		// false while the window is minimized, the output isn't drawn until it comes back
+		// only waits for this output's own frames, the other windows keep drawing
+		bool resize(Gpu const &, FrameTimeline const &);
+		void commit_magnitudes();
+		// the frame timeline value to wait for before writing the next magnitude_data, 0 if nothing to wait for
+		[[nodiscard]] uint64_t write_frame_value() const;
+		// the frame just recorded signals frame_value once it's done reading the magnitudes
+		void mark_drawn(uint64_t frame_value);
+		void set_blend(float);
+		// frames that can be waiting between recording and scanout with the current swapchain
+		[[nodiscard]] size_t queue_depth() const;
+		// null for SpectrogramImage, which always stages its columns on the graphics queue
+		[[nodiscard]] UploadBuffer const *get_upload_buffer() const;
+		// record_upload the upload buffer here unless the transfer queue copies it
+		void record_command_buffer(
+			Frame const &,
+			vk::raii::Framebuffer const &framebuffer,
+			uint32_t flight_frame,
+			bool upload
+		);
+		void record_transfer_command_buffer(Frame const &, uint32_t flight_frame) const;
+		Window &window;
+		// write the per-frame data through this, every alternative except PeakBuffer has magnitude_data in its magnitude_format
+		Geometry const &geometry{_geometry};
+		GraphicsState const &state{_state};
+		Frames frames;
+
+	private:
+		Geometry _geometry;
+		GraphicsState _state;
+
+		static Window &check_present_support(Window &, Gpu const &);
+		static Geometry create_geometry(Layout const &, Gpu const &, UploadStrategy);
+		static PipelineDescription const &get_pipeline_description(Geometry const &);
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_OUTPUT_HPP
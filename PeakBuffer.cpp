@@ -0,0 +1,100 @@
+#include "PeakBuffer.hpp"
+
+#include "constants.hpp"
+#include <algorithm>
+#include <array>
+
+namespace av {
+	std::array<vk::PushConstantRange, 1> const PeakBuffer::push_constant_ranges{
+		vk::PushConstantRange{
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.offset = 0,
+			.size = sizeof(PushConstants),
+		},
+	};
+
+	void PeakBuffer::bind_and_draw(
+		vk::raii::CommandBuffer const &command_buffer,
+		vk::raii::PipelineLayout const &pipeline_layout
+	) const {
+		vk::Buffer const buffer = *_upload_buffer.buffer;
+		command_buffer.bindVertexBuffers(0, {buffer, buffer}, {0, PEAKS_OFFSET});
+		command_buffer.pushConstants<PushConstants>(
+			*pipeline_layout, vk::ShaderStageFlagBits::eVertex, 0, _push_constants);
+		command_buffer.drawIndirect(buffer, DRAW_COMMAND_OFFSET, 1, sizeof(vk::DrawIndirectCommand));
+	}
+
+	void PeakBuffer::set_peaks(std::span<Peak const> peaks, float gain) const {
+		size_t num_peaks = std::min(peaks.size(), _peaks.size());
+		std::ranges::transform(peaks.first(num_peaks), _peaks.begin(), [gain](Peak const &peak) {
+			return Peak{peak.bin, peak.magnitude * gain};
+		});
+		_draw_command->instanceCount = static_cast<uint32_t>(num_peaks);
+	}
+
+	PeakBuffer::PeakBuffer(
+		PeakLayout const &layout,
+		Gpu const &gpu,
+		vma::Allocator const &allocator,
+		UploadStrategy upload_strategy
+	)
+		: _push_constants{.num_bins = layout.num_bins, .bins_per_octave = layout.bins_per_octave}
+		, _binding_descriptions{
+			vk::VertexInputBindingDescription{
+				.binding = 0,
+				.stride = sizeof(Vertex::Position),
+				.inputRate = vk::VertexInputRate::eVertex,
+			},
+			vk::VertexInputBindingDescription{
+				.binding = 1,
+				.stride = sizeof(Peak),
+				.inputRate = vk::VertexInputRate::eInstance,
+			},
+		}
+		, _attribute_descriptions{
+			vk::VertexInputAttributeDescription{
+				.location = 0,
+				.binding = 0,
+				.format = vk::Format::eR32G32Sfloat,
+				.offset = 0,
+			},
+			vk::VertexInputAttributeDescription{
+				.location = 1,
+				.binding = 1,
+				.format = vk::Format::eR32Sfloat,
+				.offset = offsetof(Peak, bin),
+			},
+			vk::VertexInputAttributeDescription{
+				.location = 2,
+				.binding = 1,
+				.format = vk::Format::eR32Sfloat,
+				.offset = offsetof(Peak, magnitude),
+			},
+		}
+		, _pipeline_description{
+			.vertex_shader_file_name = constants::PEAKS_VERTEX_SHADER_FILE_NAME,
+			.fragment_shader_file_name = constants::FRAGMENT_SHADER_FILE_NAME,
+			.binding_descriptions = _binding_descriptions,
+			.attribute_descriptions = _attribute_descriptions,
+			.topology = vk::PrimitiveTopology::eTriangleStrip,
+			.push_constant_ranges = push_constant_ranges,
+		}
+		, _upload_buffer{
+			gpu, allocator, PEAKS_OFFSET + layout.max_peaks * sizeof(Peak),
+			vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+			DRAW_COMMAND_OFFSET, PEAKS_OFFSET - DRAW_COMMAND_OFFSET + layout.max_peaks * sizeof(Peak),
+			upload_strategy
+		}
+		, _draw_command{reinterpret_cast<vk::DrawIndirectCommand *>(_upload_buffer.data.data() + DRAW_COMMAND_OFFSET)}
+		, _peaks{reinterpret_cast<Peak *>(_upload_buffer.data.data() + PEAKS_OFFSET), layout.max_peaks} {
+		// triangle strip
+		std::array<Vertex::Position, NUM_QUAD_VERTICES> quad{{{0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}}};
+		std::ranges::copy(quad, reinterpret_cast<Vertex::Position *>(_upload_buffer.data.data()));
+		*_draw_command = vk::DrawIndirectCommand{
+			.vertexCount = NUM_QUAD_VERTICES,
+			.instanceCount = 0,
+			.firstVertex = 0,
+			.firstInstance = 0,
+		};
+	}
+} // av
@@ -0,0 +1,54 @@
+#ifndef AUDIO_VISUALIZER_PEAKBUFFER_HPP
+#define AUDIO_VISUALIZER_PEAKBUFFER_HPP
+
+#include "Gpu.hpp"
+#include "Layout.hpp"
+#include "PeakDetector.hpp"
+#include "PipelineDescription.hpp"
+#include "UploadBuffer.hpp"
+#include "Vertex.hpp"
+#include "graphics_headers.hpp"
+#include <array>
+#include <span>
+
+namespace av {
+	// a unit quad drawn once per detected peak
+	// the peaks and the indirect draw command that says how many there are share one upload buffer,
+	// so a frame only uploads a few dozen values no matter how many bins were analyzed
+	class PeakBuffer {
+	public:
+		PeakBuffer(
+			PeakLayout const &,
+			Gpu const &,
+			vma::Allocator const &,
+			UploadStrategy
+		);
+		void bind_and_draw(vk::raii::CommandBuffer const &, vk::raii::PipelineLayout const &) const;
+		// anything past max_peaks is dropped, magnitudes are multiplied by gain
+		void set_peaks(std::span<Peak const>, float gain) const;
+		// the draw command and the peaks are uploaded every frame
+		UploadBuffer const &upload_buffer{_upload_buffer};
+		PipelineDescription const &pipeline_description{_pipeline_description};
+
+		struct PushConstants {
+			uint32_t num_bins;
+			uint32_t bins_per_octave;
+		};
+
+	private:
+		static constexpr size_t NUM_QUAD_VERTICES = 4;
+		static constexpr size_t DRAW_COMMAND_OFFSET = NUM_QUAD_VERTICES * sizeof(Vertex::Position);
+		static constexpr size_t PEAKS_OFFSET = DRAW_COMMAND_OFFSET + sizeof(vk::DrawIndirectCommand);
+		PushConstants const _push_constants;
+		std::array<vk::VertexInputBindingDescription, 2> const _binding_descriptions;
+		std::array<vk::VertexInputAttributeDescription, 3> const _attribute_descriptions;
+		PipelineDescription const _pipeline_description; // after everything it points into
+		UploadBuffer const _upload_buffer;
+		vk::DrawIndirectCommand *const _draw_command;
+		std::span<Peak> const _peaks;
+
+		static std::array<vk::PushConstantRange, 1> const push_constant_ranges;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_PEAKBUFFER_HPP
@@ -0,0 +1,72 @@
+#include "PeakDetector.hpp"
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace av {
+	namespace {
+		// quadratic through (-1, a), (0, b), (1, c), fit to log-magnitudes since spectral peaks are closer to
+		// gaussian than to parabolic
+		Peak interpolate(std::span<float const> magnitudes, size_t i) {
+			if (i == 0 || i + 1 == magnitudes.size() || !(magnitudes[i - 1] > 0.0f) || !(magnitudes[i + 1] > 0.0f))
+				return {static_cast<float>(i), magnitudes[i]};
+			float a = std::log(magnitudes[i - 1]), b = std::log(magnitudes[i]), c = std::log(magnitudes[i + 1]);
+			float curvature = a - 2.0f * b + c;
+			if (!(curvature < 0.0f)) return {static_cast<float>(i), magnitudes[i]}; // flat top
+			float offset = std::clamp(0.5f * (a - c) / curvature, -0.5f, 0.5f);
+			return {static_cast<float>(i) + offset, std::exp(b - 0.25f * (a - c) * offset)};
+		}
+	}
+
+	PeakDetector::PeakDetector(size_t num_bins, size_t max_peaks) : max_peaks{max_peaks} {
+		candidates.reserve(num_bins);
+		peaks.reserve(max_peaks);
+	}
+
+	std::span<Peak const> PeakDetector::detect(std::span<float const> magnitudes, float threshold) {
+		AV_TRACE_SCOPE("peaks");
+		size_t const n = magnitudes.size();
+		float const *m = magnitudes.data();
+		candidates.clear();
+		peaks.clear();
+		if (n == 0) return {};
+		// a peak is above its left neighbor and at least its right neighbor, so a plateau counts once
+		// the edges only have one neighbor to beat
+		auto is_peak = [&](size_t i) {
+			return m[i] > threshold && (i == 0 || m[i] > m[i - 1]) && (i + 1 == n || m[i] >= m[i + 1]);
+		};
+		if (is_peak(0)) candidates.push_back(0);
+		size_t i = 1;
+#if defined(__SSE2__)
+		__m128 const threshold_x4 = _mm_set1_ps(threshold);
+		for (; i + 4 < n; i += 4) {
+			__m128 center = _mm_loadu_ps(m + i);
+			__m128 mask = _mm_and_ps(
+				_mm_and_ps(_mm_cmpgt_ps(center, _mm_loadu_ps(m + i - 1)), _mm_cmpge_ps(center, _mm_loadu_ps(m + i + 1))),
+				_mm_cmpgt_ps(center, threshold_x4));
+			for (auto bits = static_cast<unsigned>(_mm_movemask_ps(mask)); bits; bits &= bits - 1)
+				candidates.push_back(i + std::countr_zero(bits));
+		}
+#endif
+		for (; i < n; ++i)
+			if (is_peak(i)) candidates.push_back(i);
+
+		if (candidates.size() > max_peaks) { // keep the strongest, then put them back in bin order
+			std::ranges::nth_element(
+				candidates, candidates.begin() + static_cast<std::ptrdiff_t>(max_peaks), std::ranges::greater{},
+				[&](size_t bin) { return m[bin]; });
+			candidates.resize(max_peaks);
+			std::ranges::sort(candidates);
+		}
+		for (size_t bin : candidates)
+			peaks.push_back(interpolate(magnitudes, bin));
+		return peaks;
+	}
+} // av
@@ -0,0 +1,32 @@
+#ifndef AUDIO_VISUALIZER_PEAKDETECTOR_HPP
+#define AUDIO_VISUALIZER_PEAKDETECTOR_HPP
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace av {
+	struct Peak {
+		// fractional bin index, with log-spaced bins the frequency is lo * 2^(bin / bins_per_octave)
+		float bin;
+		float magnitude;
+	};
+
+	// finds the local maxima of a magnitude array and refines each one with a parabola through the log-magnitudes
+	// of the peak bin and its two neighbors
+	class PeakDetector {
+	public:
+		PeakDetector(size_t num_bins, size_t max_peaks);
+
+		// peaks above threshold, at most max_peaks of the strongest, in ascending bin order
+		// the span stays valid until the next call
+		std::span<Peak const> detect(std::span<float const> magnitudes, float threshold);
+
+	private:
+		size_t const max_peaks;
+		std::vector<size_t> candidates;
+		std::vector<Peak> peaks;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_PEAKDETECTOR_HPP
@@ -0,0 +1,21 @@
+#ifndef AUDIO_VISUALIZER_PIPELINEDESCRIPTION_HPP
+#define AUDIO_VISUALIZER_PIPELINEDESCRIPTION_HPP
+
+#include "graphics_headers.hpp"
+#include <span>
+
+namespace av {
+	// what GraphicsState needs to know about a kind of geometry to build a pipeline for it
+	// the spans must outlive the GraphicsState, because the pipeline gets rebuilt on resize
+	struct PipelineDescription {
+		char const *vertex_shader_file_name;
+		char const *fragment_shader_file_name;
+		std::span<vk::VertexInputBindingDescription const> binding_descriptions;
+		std::span<vk::VertexInputAttributeDescription const> attribute_descriptions;
+		vk::PrimitiveTopology topology;
+		std::span<vk::PushConstantRange const> push_constant_ranges;
+		std::span<vk::DescriptorSetLayout const> set_layouts;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_PIPELINEDESCRIPTION_HPP
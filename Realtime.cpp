@@ -0,0 +1,111 @@
+#include "Realtime.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#if defined(__unix__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace av::realtime {
+#if defined(__unix__)
+	namespace {
+		constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20; // the usual x86-64 and aarch64 size
+
+		size_t round_up(size_t size, size_t alignment) {
+			return (size + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	ThreadStatus configure_current_thread(ThreadOptions const &options) {
+		ThreadStatus status;
+		if (options.priority > 0) {
+			sched_param param{};
+			param.sched_priority = options.priority;
+			status.priority_error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		}
+		if (options.cpu >= 0) {
+			cpu_set_t cpu_set;
+			CPU_ZERO(&cpu_set);
+			CPU_SET(options.cpu, &cpu_set);
+			status.cpu_error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+		}
+		return status;
+	}
+
+	void report(ThreadStatus const &status, ThreadOptions const &options, char const *thread_name) {
+		if (status.priority_error)
+			std::cerr << "warning: failed to set SCHED_FIFO priority " << options.priority << " for the "
+			          << thread_name << " thread: " << std::strerror(status.priority_error) << std::endl;
+		if (status.cpu_error)
+			std::cerr << "warning: failed to pin the " << thread_name << " thread to cpu " << options.cpu << ": "
+			          << std::strerror(status.cpu_error) << std::endl;
+	}
+
+	Memory allocate(size_t size, bool huge_pages) {
+		if (huge_pages) {
+			size_t huge_size = round_up(size, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+			void *data = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+			                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (data != MAP_FAILED) return {data, huge_size};
+#endif
+			// no reserved huge pages, ask for transparent ones instead
+			void *thp_data = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (thp_data == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+			if (madvise(thp_data, huge_size, MADV_HUGEPAGE))
+				std::cerr << "warning: huge pages are unavailable: " << std::strerror(errno) << std::endl;
+#endif
+			return {thp_data, huge_size};
+		}
+		size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		size_t rounded_size = round_up(size, page_size);
+		void *data = mmap(nullptr, rounded_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (data == MAP_FAILED) throw std::bad_alloc();
+		return {data, rounded_size};
+	}
+
+	void deallocate(Memory const &memory) {
+		munlock(memory.data, memory.size); // harmless if it was never locked
+		munmap(memory.data, memory.size);
+	}
+
+	void prefault_and_lock(Memory const &memory) {
+		// anonymous mappings start out as the shared zero page, so they have to be written to
+		std::memset(memory.data, 0, memory.size);
+		if (mlock(memory.data, memory.size))
+			std::cerr << "warning: failed to mlock " << memory.size << " bytes: " << std::strerror(errno)
+			          << " (check ulimit -l)" << std::endl;
+	}
+#else
+	ThreadStatus configure_current_thread(ThreadOptions const &options) {
+		return {options.priority > 0 ? ENOSYS : 0, options.cpu >= 0 ? ENOSYS : 0};
+	}
+
+	void report(ThreadStatus const &status, ThreadOptions const &, char const *thread_name) {
+		if (status.priority_error || status.cpu_error)
+			std::cerr << "warning: real-time scheduling of the " << thread_name
+			          << " thread is only implemented for posix systems" << std::endl;
+	}
+
+	Memory allocate(size_t size, bool) {
+		void *data = ::operator new(size);
+		std::memset(data, 0, size);
+		return {data, size};
+	}
+
+	void deallocate(Memory const &memory) {
+		::operator delete(memory.data);
+	}
+
+	void prefault_and_lock(Memory const &memory) {
+		std::memset(memory.data, 0, memory.size);
+	}
+#endif
+} // av
@@ -0,0 +1,40 @@
+#ifndef AUDIO_VISUALIZER_REALTIME_HPP
+#define AUDIO_VISUALIZER_REALTIME_HPP
+
+#include <cstddef>
+
+// helpers to keep the capture and analysis threads from page faulting or getting preempted
+// everything here is best-effort: failures are warned about instead of thrown,
+// because most systems need extra privileges (RLIMIT_MEMLOCK, RLIMIT_RTPRIO, reserved huge pages)
+namespace av::realtime {
+	struct ThreadOptions {
+		int priority = 0; // SCHED_FIFO priority (1 to 99), 0 keeps the default scheduler
+		int cpu = -1; // pin the thread to this cpu, -1 lets it run anywhere
+	};
+
+	// errno values, 0 if that part worked or wasn't asked for
+	struct ThreadStatus {
+		int priority_error = 0;
+		int cpu_error = 0;
+	};
+
+	// call from the thread itself, it never prints so an audio callback can call it
+	[[nodiscard]] ThreadStatus configure_current_thread(ThreadOptions const &);
+
+	// warns about each failure in status, call from a thread that is allowed to block
+	void report(ThreadStatus const &, ThreadOptions const &, char const *thread_name);
+
+	// zeroed, page-aligned memory
+	// with huge_pages, tries explicit huge pages first, then transparent huge pages
+	struct Memory {
+		void *data;
+		size_t size; // rounded up to the page size that was used
+	};
+	Memory allocate(size_t size, bool huge_pages);
+	void deallocate(Memory const &);
+
+	// touch every page, then mlock so they stay resident
+	void prefault_and_lock(Memory const &);
+} // av
+
+#endif //AUDIO_VISUALIZER_REALTIME_HPP
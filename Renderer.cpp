@@ -1,22 +1,33 @@
 #include "Renderer.hpp"
 
 #include "constants.hpp"
+#include "Trace.hpp"
 
-#include <array>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
 #include <limits>
-#include <span>
+#include <stdexcept>
 #include <vector>
 
 namespace av {
-	Renderer::Renderer(size_t const &num_vertices, size_t const &num_indices)
+	Renderer::Renderer(
+		std::vector<Layout> const &layouts,
+		LatencyPolicy latency_policy,
+		UploadStrategy upload_strategy
+	)
 		: vkfw_instance{vkfw::initUnique()}
-		, window{framebuffer_resized}
 		, instance{create_instance(context)}
-		, surface{instance, vkfw::createWindowSurface(*instance, *window)}
-		, gpu{instance, surface}
-		, state{surface, gpu, window->getFramebufferSize()}
-		, frames{constants::MAX_FRAMES_IN_FLIGHT, gpu}
-		, vertex_buffer{num_vertices, num_indices, gpu, gpu.allocator} {}
+		, windows{create_windows(instance, layouts.size())}
+		, gpu{instance, windows.front().surface}
+		, _upload_strategy{choose_upload_strategy(gpu, upload_strategy)}
+		, _outputs{create_outputs(windows, layouts, gpu, latency_policy, _upload_strategy)}
+		, _frame_timeline{gpu}
+		, _upload_timeline{gpu} {}
+
+	Renderer::Renderer(Layout const &layout, LatencyPolicy latency_policy, UploadStrategy upload_strategy)
+		: Renderer{std::vector<Layout>{layout}, latency_policy, upload_strategy} {}
 
 	Renderer::~Renderer() {
 		gpu.device.waitIdle(); // wait for Vulkan processes to finish
@@ -24,7 +35,7 @@ namespace av {
 	}
 
 	bool Renderer::is_running() const {
-		return !window->shouldClose();
+		return std::ranges::none_of(windows, [](Window const &window) { return window->shouldClose(); });
 	}
 
 // upload vertices to the vertex _buffer
@@ -34,50 +45,171 @@ namespace av {
 		vertex_buffer.set_vertices(vertices);
 	}*/
 
+	void Renderer::commit_magnitudes(std::chrono::steady_clock::time_point analysis_time) {
+		_previous_analysis_time = _newest_analysis_time;
+		_newest_analysis_time = analysis_time;
+		for (Output &output : _outputs) {
+			output.commit_magnitudes();
+			// with the direct strategies magnitude_data is the buffer the gpu reads, a frame in flight may still use it
+			AV_TRACE_SCOPE("wait for magnitude slot");
+			if (!_frame_timeline.wait(output.write_frame_value(), constants::FRAME_TIMEOUT_NANOSECONDS))
+				throw std::runtime_error("Vulkan frame did not finish in time");
+		}
+	}
+
+	// every output that can be drawn goes into one submit and one present,
+	// so the displays flip together and the driver is entered once per frame
 	void Renderer::draw_frame() {
-		vk::PipelineStageFlags image_available_semaphore_wait_stage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-		Frame const &frame = frames[current_flight_frame];
-		gpu.device.waitForFences({*frame.in_flight}, true, std::numeric_limits<uint64_t>::max());
-		uint32_t image_index;
-		try {
-			image_index = state.swapchain.acquireNextImage(
-				std::numeric_limits<uint64_t>::max(),
-				*frame.draw_complete, nullptr
-			).second;
-		} catch (vk::OutOfDateKHRError const &e) {
-			resize();
-			return;
+		auto const now = std::chrono::steady_clock::now();
+		if (_last_draw_time != std::chrono::steady_clock::time_point{})
+			_draw_interval_seconds +=
+				0.1 * (std::chrono::duration<double>(now - _last_draw_time).count() - _draw_interval_seconds);
+		_last_draw_time = now;
+		{
+			AV_TRACE_SCOPE("wait for frame");
+			for (Output const &output : _outputs)
+				if (!_frame_timeline.wait(output.frames[current_flight_frame].timeline_value, constants::FRAME_TIMEOUT_NANOSECONDS))
+					throw std::runtime_error("Vulkan frame did not finish in time");
 		}
-		Framebuffer const &framebuffer = state.framebuffers[image_index];
-		gpu.device.resetFences({*frame.in_flight});
-		record_graphics_command_buffer(frame.command_buffer, framebuffer.framebuffer);
-		vk::SubmitInfo graphics_queue_submit_info{
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores =  &*frame.draw_complete,
-			.pWaitDstStageMask = &image_available_semaphore_wait_stage,
-			.commandBufferCount = 1,
-			.pCommandBuffers = &*frame.command_buffer,
-			.signalSemaphoreCount = 1,
-			.pSignalSemaphores = &*frame.present_complete,
-		};
-		gpu.graphics_queue.submit({graphics_queue_submit_info}, {*frame.in_flight});
-		vk::PresentInfoKHR present_info{
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &*frame.present_complete,
-			.swapchainCount = 1,
-			.pSwapchains = &*state.swapchain,
-			.pImageIndices = &image_index,
-		};
-		try {
-			vk::Result present_result = gpu.present_queue.presentKHR(present_info);
-			if (framebuffer_resized || present_result == vk::Result::eSuboptimalKHR)
-				resize();
-		} catch (vk::OutOfDateKHRError const &e) {
-			resize();
+		uint64_t const signal_value = _frame_value.load(std::memory_order_relaxed) + 1; // this is the only writer
+		bool const transfer = uses_transfer_queue();
+		uint64_t gpu_nanoseconds = 0;
+		std::vector<Output *> drawn;
+		std::vector<uint32_t> image_indices;
+		std::vector<vk::SwapchainKHR> swapchains;
+		std::vector<vk::CommandBuffer> command_buffers;
+		std::vector<vk::CommandBuffer> transfer_command_buffers;
+		// the images are only needed for the color output, the staging copy already for the vertex input
+		std::vector<vk::Semaphore> wait_semaphores;
+		std::vector<vk::PipelineStageFlags> wait_stages;
+		std::vector<uint64_t> wait_values; // binary semaphores ignore their value
+		std::vector<vk::Semaphore> signal_semaphores;
+		std::vector<uint64_t> signal_values;
+		for (Output &output : _outputs) {
+			if (output.window.framebuffer_resized && !output.resize(gpu, _frame_timeline)) continue;
+			Frame &frame = output.frames[current_flight_frame];
+			gpu_nanoseconds += read_timestamps(frame);
+			uint32_t image_index;
+			try {
+				AV_TRACE_SCOPE("acquire image");
+				image_index = output.state.swapchain.acquireNextImage(
+					std::numeric_limits<uint64_t>::max(),
+					*frame.draw_complete, nullptr
+				).second;
+			} catch (vk::OutOfDateKHRError const &e) {
+				output.resize(gpu, _frame_timeline);
+				continue;
+			}
+			// the frame recorded now is shown after everything already queued ahead of it
+			output.set_blend(get_blend(now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double>(static_cast<double>(output.queue_depth()) * _draw_interval_seconds))));
+			{
+				AV_TRACE_SCOPE("record command buffer");
+				output.record_command_buffer(
+					frame, output.state.framebuffers[image_index].framebuffer, current_flight_frame, !transfer);
+			}
+			frame.timestamps_pending = static_cast<bool>(*frame.timestamp_query_pool);
+			frame.timeline_value = signal_value;
+			output.mark_drawn(signal_value);
+			if (transfer && output.get_upload_buffer()) {
+				output.record_transfer_command_buffer(frame, current_flight_frame);
+				transfer_command_buffers.push_back(*frame.transfer_command_buffer);
+			}
+			drawn.push_back(&output);
+			image_indices.push_back(image_index);
+			swapchains.push_back(*output.state.swapchain);
+			command_buffers.push_back(*frame.command_buffer);
+			wait_semaphores.push_back(*frame.draw_complete);
+			wait_stages.push_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+			wait_values.push_back(0);
+			signal_semaphores.push_back(*frame.present_complete);
+			signal_values.push_back(0);
+		}
+		if (gpu_nanoseconds) _gpu_nanoseconds = gpu_nanoseconds;
+		if (!drawn.empty()) {
+			if (!transfer_command_buffers.empty()) {
+				submit_transfer(transfer_command_buffers, signal_value);
+				wait_semaphores.push_back(*_upload_timeline.semaphore);
+				wait_stages.push_back(
+					vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eDrawIndirect
+					| vk::PipelineStageFlagBits::eVertexShader);
+				wait_values.push_back(signal_value);
+			}
+			// the present only waits on the binary semaphores in front of the timeline
+			uint32_t const num_present_semaphores = static_cast<uint32_t>(signal_semaphores.size());
+			signal_semaphores.push_back(*_frame_timeline.semaphore);
+			signal_values.push_back(signal_value);
+			vk::TimelineSemaphoreSubmitInfo timeline_semaphore_submit_info{
+				.waitSemaphoreValueCount = static_cast<uint32_t>(wait_values.size()),
+				.pWaitSemaphoreValues = wait_values.data(),
+				.signalSemaphoreValueCount = static_cast<uint32_t>(signal_values.size()),
+				.pSignalSemaphoreValues = signal_values.data(),
+			};
+			vk::SubmitInfo graphics_queue_submit_info{
+				.pNext = &timeline_semaphore_submit_info,
+				.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size()),
+				.pWaitSemaphores = wait_semaphores.data(),
+				.pWaitDstStageMask = wait_stages.data(),
+				.commandBufferCount = static_cast<uint32_t>(command_buffers.size()),
+				.pCommandBuffers = command_buffers.data(),
+				.signalSemaphoreCount = static_cast<uint32_t>(signal_semaphores.size()),
+				.pSignalSemaphores = signal_semaphores.data(),
+			};
+			{
+				AV_TRACE_SCOPE("queue submit");
+				gpu.graphics_queue.submit({graphics_queue_submit_info});
+			}
+			_frame_value.store(signal_value, std::memory_order_release);
+			std::vector<vk::Result> present_results(drawn.size(), vk::Result::eSuccess);
+			vk::PresentInfoKHR present_info{
+				.waitSemaphoreCount = num_present_semaphores,
+				.pWaitSemaphores = signal_semaphores.data(),
+				.swapchainCount = static_cast<uint32_t>(swapchains.size()),
+				.pSwapchains = swapchains.data(),
+				.pImageIndices = image_indices.data(),
+				.pResults = present_results.data(),
+			};
+			try {
+				AV_TRACE_SCOPE("present");
+				gpu.present_queue.presentKHR(present_info);
+			} catch (vk::OutOfDateKHRError const &e) {
+				// present_results says which of the swapchains it was
+			}
+			for (size_t i = 0; i < drawn.size(); ++i)
+				if (drawn[i]->window.framebuffer_resized || present_results[i] != vk::Result::eSuccess)
+					drawn[i]->resize(gpu, _frame_timeline);
 		}
 		vkfw::pollEvents();
 		++current_flight_frame;
-		if (current_flight_frame == constants::MAX_FRAMES_IN_FLIGHT) current_flight_frame = 0;
+		if (current_flight_frame == _outputs.front().frames.size()) current_flight_frame = 0;
+	}
+
+	// the newest frame is reached one analysis interval after it was measured, which is when the next one arrives
+	float Renderer::get_blend(std::chrono::steady_clock::time_point display_time) const {
+		double analysis_interval = std::chrono::duration<double>(_newest_analysis_time - _previous_analysis_time).count();
+		if (_previous_analysis_time == std::chrono::steady_clock::time_point{} || analysis_interval <= 0.0)
+			return 1.0f;
+		double since_newest = std::chrono::duration<double>(display_time - _newest_analysis_time).count();
+		return static_cast<float>(std::clamp(since_newest / analysis_interval, 0.0, 1.0));
+	}
+
+	size_t Renderer::queue_depth() const {
+		size_t depth = 0;
+		for (Output const &output : _outputs)
+			depth = std::max(depth, output.queue_depth());
+		return depth;
+	}
+
+	void Renderer::print_latency_report() const {
+		for (size_t i = 0; i < _outputs.size(); ++i) {
+			Output const &output = _outputs[i];
+			if (_outputs.size() > 1) std::cout << "window " << i << ", ";
+			std::cout << "latency policy " << to_string(output.state.latency_policy) << ": "
+			          << vk::to_string(output.state.surface_info.present_mode) << ", "
+			          << output.state.framebuffers.size() << " swapchain images, " << output.frames.size()
+			          << " frames in flight, up to " << output.queue_depth() << " frames queued ahead of the display"
+			          << std::endl;
+		}
 	}
 
 	vk::raii::Instance Renderer::create_instance(vk::raii::Context const &context) {
@@ -96,43 +228,71 @@ namespace av {
 		return {context, instance_create_info};
 	}
 
-	void Renderer::resize() {
-		for (;;) {
-			auto [width, height] = window->getFramebufferSize();
-			if (width && height) break;
-			vkfw::waitEvents();
-			// if window is minimized, wait until it is not minimized
-		}
-		gpu.device.waitIdle();
-		state.recreate(surface, gpu, window->getFramebufferSize());
-		framebuffer_resized = false;
+	std::deque<Window> Renderer::create_windows(vk::raii::Instance const &instance, size_t num_windows) {
+		if (!num_windows) throw std::invalid_argument("a Renderer needs at least one layout");
+		std::deque<Window> windows;
+		for (size_t i = 0; i < num_windows; ++i)
+			windows.emplace_back(instance, i);
+		return windows;
 	}
 
-	void Renderer::record_graphics_command_buffer(
-		vk::raii::CommandBuffer const &command_buffer,
-		vk::raii::Framebuffer const &framebuffer
-	) const {
-		command_buffer.reset({});
-		command_buffer.begin({});
-		{
-			vk::ClearValue clear_value{.color{.float32 = std::array{0.0f, 0.0f, 0.0f, 1.0f}}};
-			vk::RenderPassBeginInfo render_pass_begin_info{
-				.renderPass = *state.render_pass,
-				.framebuffer = *framebuffer,
-				.renderArea{
-					.offset{.x=0, .y=0},
-					.extent = state.surface_info.extent,
-				},
-				.clearValueCount = 1,
-				.pClearValues = &clear_value,
-			};
-			command_buffer.beginRenderPass(render_pass_begin_info, vk::SubpassContents::eInline);
-			{
-				command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *state.pipeline);
-				vertex_buffer.bind_and_draw(command_buffer);
-			}
-			command_buffer.endRenderPass();
-		}
-		command_buffer.end();
+	UploadStrategy Renderer::choose_upload_strategy(Gpu const &gpu, UploadStrategy upload_strategy) {
+		if (upload_strategy != UploadStrategy::automatic) return upload_strategy;
+		return UploadBuffer::benchmark(gpu, gpu.allocator, constants::UPLOAD_BENCHMARK_SIZE, true);
+	}
+
+	std::deque<Output> Renderer::create_outputs(
+		std::deque<Window> &windows,
+		std::vector<Layout> const &layouts,
+		Gpu const &gpu,
+		LatencyPolicy latency_policy,
+		UploadStrategy upload_strategy
+	) {
+		std::deque<Output> outputs;
+		for (size_t i = 0; i < layouts.size(); ++i)
+			outputs.emplace_back(windows[i], layouts[i], gpu, latency_policy, upload_strategy);
+		return outputs;
+	}
+
+	bool Renderer::uses_transfer_queue() const {
+		return _upload_strategy == UploadStrategy::staging && *gpu.transfer_queue
+		       && std::ranges::any_of(_outputs, [](Output const &output) { return output.get_upload_buffer(); });
+	}
+
+	void Renderer::submit_transfer(std::vector<vk::CommandBuffer> const &command_buffers, uint64_t signal_value) {
+		AV_TRACE_SCOPE("transfer submit");
+		// the previous frame may still be drawing from the device local buffers
+		uint64_t const wait_value = _frame_value.load(std::memory_order_relaxed);
+		vk::PipelineStageFlags const wait_stage = vk::PipelineStageFlagBits::eTransfer;
+		vk::TimelineSemaphoreSubmitInfo timeline_semaphore_submit_info{
+			.waitSemaphoreValueCount = 1,
+			.pWaitSemaphoreValues = &wait_value,
+			.signalSemaphoreValueCount = 1,
+			.pSignalSemaphoreValues = &signal_value,
+		};
+		gpu.transfer_queue.submit(vk::SubmitInfo{
+			.pNext = &timeline_semaphore_submit_info,
+			.waitSemaphoreCount = 1,
+			.pWaitSemaphores = &*_frame_timeline.semaphore,
+			.pWaitDstStageMask = &wait_stage,
+			.commandBufferCount = static_cast<uint32_t>(command_buffers.size()),
+			.pCommandBuffers = command_buffers.data(),
+			.signalSemaphoreCount = 1,
+			.pSignalSemaphores = &*_upload_timeline.semaphore,
+		});
+	}
+
+	// this frame's timeline value has already signaled, so the results should be available without waiting
+	uint64_t Renderer::read_timestamps(Frame &frame) const {
+		if (!frame.timestamps_pending) return 0;
+		auto [result, timestamps] = frame.timestamp_query_pool.getResults<uint64_t>(
+			0, 2, 2 * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+		if (result != vk::Result::eSuccess) return 0; // eNotReady, don't block
+		frame.timestamps_pending = false;
+		uint64_t const mask = gpu.timestamp_valid_bits >= 64
+		                      ? std::numeric_limits<uint64_t>::max()
+		                      : (uint64_t{1} << gpu.timestamp_valid_bits) - 1;
+		return static_cast<uint64_t>(
+			static_cast<double>((timestamps[1] - timestamps[0]) & mask) * gpu.timestamp_period);
 	}
 }
@@ -4,40 +4,88 @@
 #include "Vertex.hpp"
 #include "Window.hpp"
 #include "Gpu.hpp"
-#include "GraphicsState.hpp"
-#include "VertexBuffer.hpp"
 #include "Frame.hpp"
+#include "FrameTimeline.hpp"
+#include "Layout.hpp"
+#include "LatencyPolicy.hpp"
+#include "Output.hpp"
+#include "UploadBuffer.hpp"
 #include "graphics_headers.hpp"
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <vector>
 
 namespace av {
 	class Renderer {
 	public:
-		Renderer(size_t const &num_vertices, size_t const &num_indices);
+		// one window per layout, all drawn by one device and presented together
+		explicit Renderer(
+			std::vector<Layout> const &,
+			LatencyPolicy = LatencyPolicy::smooth,
+			UploadStrategy = UploadStrategy::automatic
+		);
+		explicit Renderer(
+			Layout const &,
+			LatencyPolicy = LatencyPolicy::smooth,
+			UploadStrategy = UploadStrategy::automatic
+		);
 		~Renderer();
 		// todo rule of 3? rule of 5? https://en.cppreference.com/w/cpp/language/rule_of_three
-		[[nodiscard]] bool is_running() const;
+		[[nodiscard]] bool is_running() const; // until any of the windows is closed
 		void draw_frame();
+		// call after writing the newest magnitudes, analysis_time is when they were measured
+		// returns once the next magnitude_data is no longer read by a frame in flight
+		// the layouts that interpolate then blend from the previous frame towards them over one analysis interval,
+		// so drawing can run faster than the analysis without the picture stepping
+		void commit_magnitudes(std::chrono::steady_clock::time_point analysis_time);
+		// the most frames any output can have waiting between recording and scanout
+		[[nodiscard]] size_t queue_depth() const;
+		void print_latency_report() const;
+		// render pass durations of the most recently completed frame, summed over the outputs, measured with gpu timestamps
+		uint64_t const &gpu_nanoseconds{_gpu_nanoseconds};
+		// frame n signals n when the gpu is done with it, other threads can wait on it
+		FrameTimeline const &frame_timeline{_frame_timeline};
+		// signaled by the most recently submitted frame, only draw_frame stores it but any thread can load it
+		std::atomic<uint64_t> const &frame_value{_frame_value};
+		UploadStrategy const &upload_strategy{_upload_strategy}; // never automatic, that is resolved at startup
+		// one per layout, in order, write the per-frame data through their geometry
+		std::deque<Output> const &outputs{_outputs};
 
 	private:
 		vkfw::UniqueInstance const vkfw_instance;
-		Window const window;
 		vk::raii::Context const context;
 		vk::raii::Instance const instance;
-		vk::raii::SurfaceKHR const surface;
-		Gpu const gpu;
-		GraphicsState state;
-		Frames const frames;
-		VertexBuffer vertex_buffer;
+		std::deque<Window> windows; // deques never move their elements, the windows and outputs point at each other
+		Gpu const gpu; // chosen for the first window
+		UploadStrategy const _upload_strategy;
+		std::deque<Output> _outputs;
+		FrameTimeline _frame_timeline;
+		FrameTimeline _upload_timeline; // frame n's staging copy on the transfer queue signals n
+		std::atomic<uint64_t> _frame_value{0};
 		uint32_t current_flight_frame = 0; // for multiple frames in flight
-		bool framebuffer_resized = false;
+		uint64_t _gpu_nanoseconds = 0;
+		std::chrono::steady_clock::time_point _previous_analysis_time{};
+		std::chrono::steady_clock::time_point _newest_analysis_time{};
+		std::chrono::steady_clock::time_point _last_draw_time{};
+		double _draw_interval_seconds = 0.0; // smoothed, used to guess when a frame reaches the display
 
 		static vk::raii::Instance create_instance(vk::raii::Context const &);
-		void resize();
-		void record_graphics_command_buffer(
-			vk::raii::CommandBuffer const &command_buffer,
-			vk::raii::Framebuffer const &framebuffer
-		) const;
+		static std::deque<Window> create_windows(vk::raii::Instance const &, size_t num_windows);
+		static UploadStrategy choose_upload_strategy(Gpu const &, UploadStrategy);
+		static std::deque<Output> create_outputs(
+			std::deque<Window> &,
+			std::vector<Layout> const &,
+			Gpu const &,
+			LatencyPolicy,
+			UploadStrategy
+		);
+		// 0 if the frame has no timestamps to read yet
+		[[nodiscard]] uint64_t read_timestamps(Frame &) const;
+		// how far between the previous and the newest analysis frame a frame shown at display_time should be
+		[[nodiscard]] float get_blend(std::chrono::steady_clock::time_point display_time) const;
+		[[nodiscard]] bool uses_transfer_queue() const;
+		void submit_transfer(std::vector<vk::CommandBuffer> const &, uint64_t signal_value);
 	};
 } // av
 
@@ -0,0 +1,62 @@
+#ifndef AUDIO_VISUALIZER_SHAREDSPECTRUM_HPP
+#define AUDIO_VISUALIZER_SHAREDSPECTRUM_HPP
+
+// memory layout of the posix shared memory object written by SpectrumPublisher and read by SpectrumReader
+// only depends on the standard library, so other programs can include it as-is
+//
+// Header
+// float frequencies[num_bins]
+// num_slots * slot_size bytes of Slot, each followed by float magnitudes[num_bins]
+//
+// every slot is a seqlock: its sequence is odd while the publisher writes it
+// readers copy the slot and retry if the sequence changed in the meantime, so they never block the publisher
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace av::shared_spectrum {
+	static constexpr uint64_t MAGIC = 0x3154434550535641; // "AVSPECT1"
+	static constexpr uint32_t VERSION = 1;
+
+	struct Header {
+		std::atomic<uint64_t> magic; // written last, so a reader never sees a half-initialized header
+		uint32_t version;
+		uint32_t num_bins;
+		uint32_t num_slots;
+		uint32_t slot_size; // bytes, including the Slot itself
+		std::atomic<float> sample_rate; // of the capture device, changes when the publisher switches devices
+		uint32_t reserved;
+		// total number of frames published, the newest one is in slot (frames_published - 1) % num_slots
+		std::atomic<uint64_t> frames_published;
+	};
+
+	struct Slot {
+		std::atomic<uint64_t> sequence;
+		uint64_t frame_index;
+		int64_t timestamp_nanoseconds; // std::chrono::steady_clock, which is CLOCK_MONOTONIC on linux
+		uint64_t reserved;
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "the atomics have to work across processes");
+	static_assert(std::atomic<float>::is_always_lock_free && sizeof(std::atomic<float>) == sizeof(float));
+	static_assert(sizeof(Header) % alignof(Slot) == 0);
+
+	inline size_t frequencies_offset() { return sizeof(Header); }
+
+	inline size_t slots_offset(uint32_t num_bins) {
+		size_t end_of_frequencies = frequencies_offset() + num_bins * sizeof(float);
+		return (end_of_frequencies + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+	}
+
+	inline uint32_t slot_size(uint32_t num_bins) {
+		size_t size = sizeof(Slot) + num_bins * sizeof(float);
+		return static_cast<uint32_t>((size + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot));
+	}
+
+	inline size_t total_size(uint32_t num_bins, uint32_t num_slots) {
+		return slots_offset(num_bins) + size_t{num_slots} * slot_size(num_bins);
+	}
+} // av
+
+#endif //AUDIO_VISUALIZER_SHAREDSPECTRUM_HPP
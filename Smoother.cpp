@@ -0,0 +1,65 @@
+#include "Smoother.hpp"
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace av {
+	namespace {
+		// how much of the old value is left after elapsed_seconds, for a one-pole filter
+		float retention(float elapsed_seconds, float milliseconds) {
+			return milliseconds > 0.0f ? std::exp(-1000.0f * elapsed_seconds / milliseconds) : 0.0f;
+		}
+	}
+
+	Smoother::Smoother(size_t num_bins, SmoothingOptions const &options)
+		: options{options}
+		, band_size{options.agc_band_size ? options.agc_band_size : std::max<size_t>(num_bins, 1)}
+		, envelope(num_bins, 0.0f)
+		, band_peaks((num_bins + band_size - 1) / band_size, 0.0f) {}
+
+	void Smoother::process(std::span<float const> magnitudes, float elapsed_seconds, std::span<float> levels) noexcept {
+		AV_TRACE_SCOPE("smooth");
+		size_t const n = std::min({magnitudes.size(), levels.size(), envelope.size()});
+		float const attack = retention(elapsed_seconds, options.attack_milliseconds);
+		float const release = retention(elapsed_seconds, options.release_milliseconds);
+		float const agc_release = retention(elapsed_seconds, options.agc_release_milliseconds);
+		float const *x = magnitudes.data();
+		float *y = envelope.data();
+
+		// y += (1 - retention) * (x - y), with the retention picked per bin
+		size_t i = 0;
+#if defined(__SSE2__)
+		__m128 const attack_x4 = _mm_set1_ps(attack), release_x4 = _mm_set1_ps(release);
+		for (; i + 4 <= n; i += 4) {
+			__m128 input = _mm_loadu_ps(x + i), state = _mm_loadu_ps(y + i);
+			__m128 rising = _mm_cmpgt_ps(input, state);
+			__m128 kept = _mm_or_ps(_mm_and_ps(rising, attack_x4), _mm_andnot_ps(rising, release_x4));
+			_mm_storeu_ps(y + i, _mm_add_ps(input, _mm_mul_ps(kept, _mm_sub_ps(state, input))));
+		}
+#endif
+		for (; i < n; ++i)
+			y[i] = x[i] + (x[i] > y[i] ? attack : release) * (y[i] - x[i]);
+
+		for (size_t band = 0; band < band_peaks.size(); ++band) {
+			size_t begin = std::min(band * band_size, n), end = std::min(begin + band_size, n);
+			if (begin == end) break;
+			float loudest = *std::max_element(y + begin, y + end);
+			band_peaks[band] = std::max(band_peaks[band] * agc_release, loudest);
+			float gain = 1.0f / std::max(band_peaks[band], options.agc_floor);
+			i = begin;
+#if defined(__SSE2__)
+			__m128 const gain_x4 = _mm_set1_ps(gain);
+			for (; i + 4 <= end; i += 4)
+				_mm_storeu_ps(levels.data() + i, _mm_mul_ps(_mm_loadu_ps(y + i), gain_x4));
+#endif
+			for (; i < end; ++i)
+				levels[i] = y[i] * gain;
+		}
+	}
+} // av
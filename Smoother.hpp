@@ -0,0 +1,37 @@
+#ifndef AUDIO_VISUALIZER_SMOOTHER_HPP
+#define AUDIO_VISUALIZER_SMOOTHER_HPP
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace av {
+	// every time constant is in real time, so the result doesn't depend on the frame rate or on dropped frames
+	struct SmoothingOptions {
+		// per-bin envelope, each bin moves towards a rising input with attack and towards a falling one with release
+		float attack_milliseconds = 10.0f;
+		float release_milliseconds = 100.0f;
+		// automatic gain control: each band of bins is divided by a peak follower of its loudest bin,
+		// which jumps up instantly and decays with agc_release
+		// 0 makes the whole spectrum one band (the old global normalization), 1 normalizes every bin on its own
+		size_t agc_band_size = 0;
+		float agc_release_milliseconds = 200.0f; // about what the old per-frame dampening of 0.95 did at 90 fps
+		float agc_floor = 1e-12f; // the follower never goes below this, so silence isn't amplified into noise
+	};
+
+	class Smoother {
+	public:
+		Smoother(size_t num_bins, SmoothingOptions const &);
+
+		// elapsed_seconds is the real time since the previous call, levels gets the normalized envelope
+		void process(std::span<float const> magnitudes, float elapsed_seconds, std::span<float> levels) noexcept;
+
+	private:
+		SmoothingOptions const options;
+		size_t const band_size;
+		std::vector<float> envelope;
+		std::vector<float> band_peaks;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_SMOOTHER_HPP
@@ -4,5 +4,169 @@
 
 #include "SoundAnalyzer.hpp"
 
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
 namespace av {
+	SoundAnalyzer::SoundAnalyzer(
+		std::span<long double const> frequencies,
+		size_t bins_per_octave,
+		float hop_rate,
+		SoundAnalyzerOptions const &options
+	)
+		: options{options}
+		, hop_rate{hop_rate}
+		, previous(frequencies.size(), 0.0f)
+		, flux_history(std::max<size_t>(1, std::lround(options.median_seconds * hop_rate)), 0.0f)
+		, sorted_flux(flux_history.size(), 0.0f)
+		, min_onset_interval{static_cast<size_t>(std::lround(options.min_onset_interval_seconds * hop_rate))}
+		, envelope(std::bit_ceil(std::max<size_t>(options.tempo_history, 16)), 0.0f)
+		, spectrum(envelope.size() * 2)
+		, twiddles(spectrum.size() / 2)
+		, bit_reversal(spectrum.size())
+		, autocorrelation(envelope.size() / 2) {
+		if (!(hop_rate > 0.0f))
+			throw std::invalid_argument("hop_rate must be positive");
+		if (!(options.min_bpm > 0.0f && options.min_bpm < options.max_bpm))
+			throw std::invalid_argument("min_bpm must be positive and less than max_bpm");
+		if (options.tempo_interval == 0)
+			throw std::invalid_argument("tempo_interval must be positive");
+		for (size_t i = 0; i < twiddles.size(); ++i)
+			twiddles[i] = std::polar(1.0f, static_cast<float>(-2.0 * std::numbers::pi * i / spectrum.size()));
+		int bits = std::countr_zero(spectrum.size());
+		for (uint32_t i = 0; i < bit_reversal.size(); ++i) {
+			uint32_t reversed = 0;
+			for (int bit = 0; bit < bits; ++bit)
+				reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+			bit_reversal[i] = reversed;
+		}
+		if (options.chroma_classes)
+			chroma.emplace(frequencies, bins_per_octave, options.chroma_classes);
+	}
+
+	SoundAnalyzer::Features const &SoundAnalyzer::analyze(std::span<float const> magnitudes, float gain) noexcept {
+		AV_TRACE_SCOPE("analyze");
+		detect_onset(magnitudes, gain);
+		if (chroma) _features.chroma = chroma->compute(magnitudes);
+		envelope[hop % envelope.size()] = _features.flux;
+		if (hop >= envelope.size() / 2 && hop % options.tempo_interval == 0)
+			update_tempo();
+		track_beat();
+		++hop;
+		return _features;
+	}
+
+	void SoundAnalyzer::detect_onset(std::span<float const> magnitudes, float gain) {
+		size_t num_bins = std::min(magnitudes.size(), previous.size());
+		float flux = 0.0f;
+		for (size_t i = 0; i < num_bins; ++i) {
+			float compressed = std::log1p(options.compression * gain * magnitudes[i]);
+			flux += std::max(compressed - previous[i], 0.0f);
+			previous[i] = compressed;
+		}
+		if (num_bins) flux /= static_cast<float>(num_bins);
+		if (hop == 0 || !std::isfinite(flux)) flux = 0.0f; // nothing to compare against, or garbage in
+
+		// swap the oldest flux for the newest in the sorted window, one shift instead of a sort
+		float &oldest = flux_history[hop % flux_history.size()];
+		auto removed = std::ranges::lower_bound(sorted_flux, oldest);
+		auto inserted = std::ranges::lower_bound(sorted_flux, flux);
+		if (inserted > removed)
+			*std::shift_left(removed, inserted, 1) = flux;
+		else {
+			std::shift_right(inserted, removed + 1, 1);
+			*inserted = flux;
+		}
+		oldest = flux;
+		float median = sorted_flux[sorted_flux.size() / 2];
+
+		_features.flux = flux;
+		_features.threshold = options.threshold_multiplier * median + options.threshold_offset;
+		// rising edge over the threshold, so the onset is reported on the hop it happens instead of one later
+		_features.onset = flux > _features.threshold && flux > previous_flux && hop - last_onset >= min_onset_interval;
+		if (_features.onset) last_onset = hop;
+		previous_flux = flux;
+	}
+
+	// autocorrelation of the mean-removed envelope via the wiener-khinchin theorem
+	void SoundAnalyzer::update_tempo() {
+		AV_TRACE_SCOPE("tempo");
+		size_t n = envelope.size();
+		float mean = 0.0f;
+		for (float value : envelope) mean += value;
+		mean /= static_cast<float>(n);
+		for (size_t i = 0; i < n; ++i) // oldest first
+			spectrum[i] = envelope[(hop + 1 + i) % n] - mean;
+		std::ranges::fill(spectrum.begin() + static_cast<std::ptrdiff_t>(n), spectrum.end(), 0.0f);
+		fft(spectrum);
+		for (auto &bin : spectrum) bin = std::norm(bin);
+		fft(spectrum); // the power spectrum is real and even, so the forward transform is the inverse up to scale
+		for (size_t lag = 0; lag < autocorrelation.size(); ++lag) // unbiased
+			autocorrelation[lag] = spectrum[lag].real() / static_cast<float>(n - lag);
+		if (!(autocorrelation[0] > 0.0f)) return; // silence
+
+		float hops_per_minute = 60.0f * hop_rate;
+		size_t lo_lag = std::max<size_t>(1, static_cast<size_t>(std::ceil(hops_per_minute / options.max_bpm)));
+		size_t hi_lag = std::min(autocorrelation.size() - 2, static_cast<size_t>(hops_per_minute / options.min_bpm));
+		float preferred_lag = hops_per_minute / options.preferred_bpm;
+		size_t best_lag = 0;
+		float best_score = 0.0f;
+		for (size_t lag = lo_lag; lag <= hi_lag; ++lag) {
+			float octaves = std::log2(static_cast<float>(lag) / preferred_lag);
+			float score = autocorrelation[lag] * std::exp(-0.5f * octaves * octaves); // 1 octave deviation
+			if (score > best_score) best_score = score, best_lag = lag;
+		}
+		if (!best_lag) return;
+		// sub-hop period from a parabola through the neighbors
+		float a = autocorrelation[best_lag - 1], b = autocorrelation[best_lag], c = autocorrelation[best_lag + 1];
+		float curvature = a - 2.0f * b + c;
+		float offset = curvature < 0.0f ? std::clamp(0.5f * (a - c) / curvature, -0.5f, 0.5f) : 0.0f;
+		period = static_cast<float>(best_lag) + offset;
+		_features.tempo = hops_per_minute / period;
+	}
+
+	// a beat is due every period hops, and onsets close to a predicted beat pull the prediction towards them
+	void SoundAnalyzer::track_beat() {
+		_features.beat = false;
+		if (!(period > 0.0f)) return;
+		double now = static_cast<double>(hop);
+		if (next_beat <= 0.0) next_beat = now + period; // tempo just became known
+		double tolerance = options.beat_tolerance * period;
+		if (_features.onset) {
+			if (next_beat - now <= tolerance) { // a little early, take the onset as the beat
+				_features.beat = true;
+				next_beat = now + period;
+			} else if (now - (next_beat - period) <= tolerance) // a little late, nudge the next one
+				next_beat += options.beat_correction * (now - (next_beat - period));
+		}
+		if (!_features.beat && now >= next_beat) {
+			_features.beat = true;
+			next_beat += period;
+			if (next_beat <= now) next_beat = now + period; // the period shrank
+		}
+		_features.beat_phase = static_cast<float>(std::clamp(1.0 - (next_beat - now) / period, 0.0, 1.0));
+	}
+
+	// in-place iterative radix-2
+	void SoundAnalyzer::fft(std::span<std::complex<float>> data) const {
+		size_t n = data.size();
+		for (size_t i = 0; i < n; ++i)
+			if (i < bit_reversal[i]) std::swap(data[i], data[bit_reversal[i]]);
+		for (size_t length = 2; length <= n; length *= 2) {
+			size_t stride = n / length;
+			for (size_t start = 0; start < n; start += length)
+				for (size_t k = 0; k < length / 2; ++k) {
+					std::complex<float> even = data[start + k];
+					std::complex<float> odd = data[start + k + length / 2] * twiddles[k * stride];
+					data[start + k] = even + odd;
+					data[start + k + length / 2] = even - odd;
+				}
+		}
+	}
+
 } // av
@@ -5,10 +5,92 @@
 #ifndef AUDIO_VISUALIZER_SOUNDANALYZER_HPP
 #define AUDIO_VISUALIZER_SOUNDANALYZER_HPP
 
+#include "Chroma.hpp"
+
+#include <complex>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
 namespace av {
+	struct SoundAnalyzerOptions {
+		// magnitudes are compressed with log(1 + compression * magnitude) before taking the flux
+		float compression = 100.0f;
+		// a hop is an onset if its flux beats threshold_multiplier * (median of the last median_seconds) + threshold_offset
+		float median_seconds = 0.5f;
+		float threshold_multiplier = 1.5f;
+		float threshold_offset = 0.01f;
+		float min_onset_interval_seconds = 0.1f;
+		// the tempo is the strongest autocorrelation peak of the last tempo_history hops (rounded up to a power of 2),
+		// weighted towards preferred_bpm
+		size_t tempo_history = 512;
+		size_t tempo_interval = 8; // hops between tempo updates
+		float min_bpm = 60.0f;
+		float max_bpm = 200.0f;
+		float preferred_bpm = 120.0f;
+		// onsets this close to a predicted beat (as a fraction of the beat period) pull the beat phase towards them
+		float beat_tolerance = 0.2f;
+		float beat_correction = 0.3f;
+		size_t chroma_classes = 12; // 0 to skip the chroma, see Chroma.hpp
+	};
 
+	// onset, beat and chroma features of the per-hop magnitude stream, one analyze() per analysis frame
+	// everything is preallocated, so it can run in the render loop
 	class SoundAnalyzer {
+	public:
+		struct Features {
+			float flux; // half-wave rectified, averaged over the bins
+			float threshold;
+			bool onset;
+			bool beat;
+			float tempo; // bpm, 0 until there is enough history
+			float beat_phase; // 0 on a beat, approaching 1 just before the next one
+			std::span<float const> chroma; // chroma_classes values, the strongest is 1
+		};
+
+		// frequencies are the bins of the magnitudes, log-spaced with bins_per_octave per octave
+		// hop_rate is the number of analyze() calls per second, which has to be roughly constant
+		SoundAnalyzer(
+			std::span<long double const> frequencies,
+			size_t bins_per_octave,
+			float hop_rate,
+			SoundAnalyzerOptions const & = {}
+		);
+
+		// every magnitude is multiplied by gain first (e.g. to normalize)
+		Features const &analyze(std::span<float const> magnitudes, float gain = 1.0f) noexcept;
+
+		Features const &features{_features};
+
+	private:
+		SoundAnalyzerOptions const options;
+		float const hop_rate;
+		Features _features{};
+		uint64_t hop = 0;
+		std::optional<Chroma> chroma;
+
+		// onsets
+		std::vector<float> previous; // compressed magnitudes of the previous hop
+		std::vector<float> flux_history; // ring of median_window values
+		std::vector<float> sorted_flux; // the same values, kept sorted for the median
+		float previous_flux = 0.0f;
+		uint64_t last_onset = 0;
+		size_t const min_onset_interval;
+
+		// tempo
+		std::vector<float> envelope; // ring of the last envelope.size() fluxes
+		std::vector<std::complex<float>> spectrum; // 2 * envelope.size(), zero padded for a linear autocorrelation
+		std::vector<std::complex<float>> twiddles;
+		std::vector<uint32_t> bit_reversal;
+		std::vector<float> autocorrelation;
+		float period = 0.0f; // hops per beat, 0 if unknown
+		double next_beat = 0.0; // hop index of the predicted next beat
 
+		void detect_onset(std::span<float const> magnitudes, float gain);
+		void update_tempo();
+		void track_beat();
+		void fft(std::span<std::complex<float>>) const;
 	};
 
 } // av
@@ -1,30 +1,136 @@
 #include "SoundRecorder.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 // useful: https://miniaudio.docsforge.com/master/api/ma_device/
 
 namespace av {
-	SoundRecorder::SoundRecorder(size_t min_history_samples) {
+	namespace {
+		// an index into the capture devices, or else the first one whose name contains selector (ignoring case)
+		ma_device_info const *find_capture_device(ma_context &context, std::string_view selector) {
+			ma_device_info *capture_infos;
+			ma_uint32 capture_count;
+			if (ma_context_get_devices(&context, nullptr, nullptr, &capture_infos, &capture_count) != MA_SUCCESS)
+				throw std::runtime_error("miniaudio failed to get audio devices");
+			ma_uint32 index;
+			auto [end, error] = std::from_chars(selector.data(), selector.data() + selector.size(), index);
+			if (error == std::errc{} && end == selector.data() + selector.size())
+				return index < capture_count ? &capture_infos[index] : nullptr;
+			auto lower = [](std::string_view string) {
+				std::string result{string};
+				std::ranges::transform(result, result.begin(), [](unsigned char c) { return std::tolower(c); });
+				return result;
+			};
+			std::string needle = lower(selector);
+			for (ma_uint32 i = 0; i < capture_count; ++i)
+				if (lower(capture_infos[i].name).find(needle) != std::string::npos)
+					return &capture_infos[i];
+			return nullptr;
+		}
+	}
+
+	SoundRecorder::SoundRecorder(size_t min_history_samples, CaptureOptions const &options, char const *device_name)
+		: min_history_samples{min_history_samples}
+		, options{options} {
+		if (ma_context_init(nullptr, 0, nullptr, &context) != MA_SUCCESS)
+			throw std::runtime_error("miniaudio failed to initialize context");
+		try {
+			init_device(find_device(device_name));
+		} catch (...) {
+			ma_context_uninit(&context);
+			throw;
+		}
+		try {
+			allocate_history(get_history_length());
+		} catch (...) {
+			ma_device_uninit(&device);
+			ma_context_uninit(&context);
+			throw;
+		}
+	}
+
+	SoundRecorder::~SoundRecorder() {
+		ma_device_uninit(&device); // stops the capture thread before the history goes away
+		ma_context_uninit(&context);
+		realtime::deallocate(sample_history);
+	}
+
+	size_t SoundRecorder::get_history_length() const {
+		// round the history length up to the nearest period_size_in_frames
+		return (min_history_samples + frames_per_period - 1) / frames_per_period * frames_per_period
+		       + GUARD_PERIODS * frames_per_period;
+	}
+
+	void SoundRecorder::allocate_history(size_t length) {
+		sample_history = realtime::allocate(length * sizeof(float), options.huge_pages); // zeroed
+		if (options.lock_history)
+			realtime::prefault_and_lock(sample_history);
+		sample_history_begin = static_cast<float *>(sample_history.data);
+		sample_history_end = sample_history_begin + length;
+		sample_history_ptr.store(sample_history_begin, std::memory_order_release);
+	}
+
+	ma_device_id const *SoundRecorder::find_device(char const *device_name) {
+		if (!device_name) return nullptr;
+		ma_device_info const *info = find_capture_device(context, device_name);
+		if (!info)
+			throw std::invalid_argument(std::string{"no capture device matches "} + device_name);
+		return &info->id;
+	}
+
+	void SoundRecorder::init_device(ma_device_id const *id) {
 		ma_device_config config = ma_device_config_init(ma_device_type_capture);
 		config.sampleRate = 0;
 		config.dataCallback = data_callback;
 		config.pUserData = this;
 		config.capture.format = ma_format_f32;
-		config.capture.channels = 1; // todo multiple channels
-		if (ma_device_init(nullptr, &config, &device) != MA_SUCCESS)
+		config.capture.channels = options.meter_loudness ? 0 : 1; // 0 is the device's own channel count
+		config.capture.pDeviceID = id;
+		if (ma_device_init(&context, &config, &device) != MA_SUCCESS)
 			throw std::runtime_error("miniaudio failed to initialize device");
-		// round the history length up to the nearest period_size_in_frames
-		size_t sample_history_length =
-			(min_history_samples + frames_per_period - 1) / frames_per_period * frames_per_period;
-		sample_history = new float[sample_history_length](); // zero-initialized
-		sample_history_ptr = sample_history_begin = sample_history;
-		sample_history_end = sample_history_begin + sample_history_length;
+		capture_thread_configured.store(false, std::memory_order_relaxed); // miniaudio made a new thread
+		_loudness_meter.reset();
+		if (options.meter_loudness)
+			_loudness_meter.emplace(get_sample_rate(), device.capture.channels);
 	}
 
-	SoundRecorder::~SoundRecorder() {
-		delete[] sample_history;
+	void SoundRecorder::switch_device(char const *device_name) {
+		ma_device_id const *id = find_device(device_name); // before touching the running device
+		std::optional<ma_device_id> previous_id;
+		if (device.capture.pID) previous_id = device.capture.id;
 		ma_device_uninit(&device);
+		std::fill(sample_history_begin, sample_history_end, 0.0f); // don't analyze the old device at the new rate
+		sample_history_ptr.store(sample_history_begin, std::memory_order_release);
+		bool initialized = false;
+		try {
+			init_device(id);
+			initialized = true;
+			// GUARD_PERIODS only protects readers if it counts periods of the device that's actually running
+			// nothing is capturing yet and the caller is the only reader, so the history can move
+			if (size_t length = get_history_length(); length > static_cast<size_t>(sample_history_end - sample_history_begin)) {
+				realtime::Memory old_history = sample_history;
+				allocate_history(length);
+				realtime::deallocate(old_history);
+			}
+			start();
+		} catch (std::exception const &err) {
+			std::string message = std::string{"couldn't switch capture devices: "} + err.what();
+			if (initialized) ma_device_uninit(&device);
+			try {
+				init_device(previous_id ? &*previous_id : nullptr);
+				start();
+			} catch (std::exception const &fallback_err) {
+				ma_device_uninit(&device);
+				throw std::runtime_error(message + ", and the previous device failed too: " + fallback_err.what());
+			}
+			throw std::runtime_error(message);
+		}
 	}
 
 	void SoundRecorder::print_recording_devices() {
@@ -41,7 +147,7 @@ namespace av {
 
 		std::cout << "capture devices (* denotes default):" << std::endl;
 		for (ma_uint32 i = 0; i < captureDeviceCount; ++i) {
-			std::cout << '\t';
+			std::cout << '\t' << i << ": ";
 			if (pCaptureDeviceInfos[i].isDefault)
 				std::cout << "* ";
 			std::cout << pCaptureDeviceInfos[i].name << std::endl;
@@ -60,23 +166,56 @@ namespace av {
 
 	float SoundRecorder::get_sample_rate() const { return static_cast<float>(device.sampleRate); }
 
+	char const *SoundRecorder::get_device_name() const { return device.capture.name; }
+
+	void SoundRecorder::report_capture_thread() {
+		if (capture_thread_status_ready.exchange(false, std::memory_order_acquire))
+			realtime::report(capture_thread_status, options.capture_thread, "capture");
+	}
+
 	void SoundRecorder::data_callback(
 		ma_device *pDevice,
 		void *const pOutput,
 		void const *const pInput,
 		ma_uint32 frameCount
 	) {
-//	todo maybe implement downmixing manually: https://dsp.stackexchange.com/q/3581
 		auto *rec = static_cast<SoundRecorder *>(pDevice->pUserData);
-		float *sample_history_ptr_new = rec->sample_history_ptr + frameCount;
-		if (sample_history_ptr_new >= rec->sample_history_end) {
-			rec->sample_history_ptr = rec->sample_history_begin;
-			sample_history_ptr_new = rec->sample_history_ptr + frameCount;
+		if (!rec->capture_thread_configured.exchange(true, std::memory_order_relaxed)) {
+			rec->capture_trace.bind();
+			rec->capture_thread_status = realtime::configure_current_thread(rec->options.capture_thread);
+			rec->capture_thread_status_ready.store(true, std::memory_order_release);
+		}
+		AV_TRACE_SCOPE("data_callback");
+		auto const length = static_cast<size_t>(rec->sample_history_end - rec->sample_history_begin);
+		auto const *input = static_cast<float const *>(pInput);
+		ma_uint32 const channels = pDevice->capture.channels;
+		if (rec->_loudness_meter) {
+			AV_TRACE_SCOPE("loudness");
+			rec->_loudness_meter->process(input, frameCount);
+		}
+		if (frameCount > length) { // only the newest samples fit
+			input += (frameCount - length) * channels;
+			frameCount = length;
+		}
+		// wrap around, so the history is always contiguous modulo its length
+		float *ptr = rec->sample_history_ptr.load(std::memory_order_relaxed);
+		size_t until_end = rec->sample_history_end - ptr;
+		if (channels != 1) { // plain average, see https://dsp.stackexchange.com/q/3581
+			for (ma_uint32 frame = 0; frame < frameCount; ++frame, input += channels) {
+				float sum = 0.0f;
+				for (ma_uint32 channel = 0; channel < channels; ++channel)
+					sum += input[channel];
+				*ptr = sum / static_cast<float>(channels);
+				if (++ptr == rec->sample_history_end) ptr = rec->sample_history_begin;
+			}
+		} else if (frameCount < until_end) {
+			std::copy(input, input + frameCount, ptr);
+			ptr += frameCount;
+		} else {
+			std::copy(input, input + until_end, ptr);
+			ptr = std::copy(input + until_end, input + frameCount, rec->sample_history_begin);
 		}
-		auto const input = static_cast<float const *>(pInput);
-		std::copy(input, input + frameCount, rec->sample_history_ptr);
-		rec->sample_history_ptr = sample_history_ptr_new;
+		rec->sample_history_ptr.store(ptr, std::memory_order_release);
 //		todo using rec->device.capture.pIntermediaryBuffer could save a copy
-//		todo i believe i'm using frameCount unsafely
 	}
 } // av
@@ -1,15 +1,38 @@
 #ifndef AUDIO_VISUALIZER_SOUNDRECORDER_HPP
 #define AUDIO_VISUALIZER_SOUNDRECORDER_HPP
 
+#include "LoudnessMeter.hpp"
+#include "Realtime.hpp"
+#include "Trace.hpp"
+
 #include <miniaudio/miniaudio.h>
 
+#include <atomic>
+#include <optional>
+
 namespace av {
+	struct CaptureOptions {
+		// prefault and mlock the sample history so the capture thread never page faults on it
+		bool lock_history = false;
+		bool huge_pages = false;
+		// applied from the capture thread on its first callback
+		realtime::ThreadOptions capture_thread{};
+		// capture every channel of the device instead of letting miniaudio downmix,
+		// meter them on the capture thread and downmix into the history by hand
+		bool meter_loudness = false;
+	};
+
 	class SoundRecorder {
 	public:
 		// todo const
-		float *sample_history_begin, *sample_history_end, *sample_history_ptr;
+		// the sample history is a ring buffer, the newest sample is just before sample_history_ptr
+		float *sample_history_begin, *sample_history_end;
+		std::atomic<float *> sample_history_ptr;
 
-		explicit SoundRecorder(size_t min_history_samples);
+		// the history holds at least min_history_samples, plus a few periods so the capture thread
+		// can't lap a reader that is still going through the last min_history_samples
+		// device is an index from print_recording_devices or part of a device name, nullptr is the system default
+		SoundRecorder(size_t min_history_samples, CaptureOptions const &, char const *device = nullptr);
 
 		~SoundRecorder();
 
@@ -19,12 +42,47 @@ namespace av {
 
 		void stop();
 
+		// replaces only the miniaudio device, the history stays where it is (zeroed) and capture restarts right away
+		// call it from the thread that reads the history, and check get_sample_rate afterwards
+		// a device with longer periods gets a bigger history, so the guard periods still cover a whole period each
+		// if the new device doesn't work, the old one is brought back and this throws
+		// if the old one fails as well, nothing is captured (and get_sample_rate is 0) until a switch succeeds
+		void switch_device(char const *device);
+
 		[[nodiscard]] float get_sample_rate() const;
 
+		[[nodiscard]] char const *get_device_name() const;
+
+		// warns if CaptureOptions::capture_thread couldn't be applied, once per device
+		// the capture thread can't print itself, so call this regularly from the thread that calls switch_device
+		void report_capture_thread();
+
+		// only with CaptureOptions::meter_loudness, read it with readings()
+		std::optional<LoudnessMeter> const &loudness_meter{_loudness_meter};
+
 	private:
+		static constexpr size_t GUARD_PERIODS = 4;
+		ma_context context;
 		ma_device device;
 		ma_uint32 const &frames_per_period = device.capture.internalPeriodSizeInFrames;
-		float *sample_history;
+		size_t const min_history_samples;
+		CaptureOptions const options;
+		realtime::Memory sample_history;
+		std::atomic<bool> capture_thread_configured{false};
+		// written once by the capture thread, then published through capture_thread_status_ready
+		realtime::ThreadStatus capture_thread_status;
+		std::atomic<bool> capture_thread_status_ready{false};
+		// registered here so the capture thread only binds it, every device switch reuses it
+		trace::Thread capture_trace{"capture"};
+		std::optional<LoudnessMeter> _loudness_meter;
+
+		// only the device, the history has to exist already, nullptr is the system default
+		void init_device(ma_device_id const *);
+		// for the current device's period size
+		[[nodiscard]] size_t get_history_length() const;
+		// replaces sample_history without freeing the old one
+		void allocate_history(size_t length);
+		ma_device_id const *find_device(char const *device);
 
 		// when there's new audio, this function will get called
 		static void data_callback(ma_device *pDevice, void *pOutput, void const *pInput, ma_uint32 frameCount);
@@ -0,0 +1,302 @@
+#include "SpectrogramImage.hpp"
+
+#include "constants.hpp"
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace av {
+	std::array<vk::PushConstantRange, 1> const SpectrogramImage::push_constant_ranges{
+		vk::PushConstantRange{
+			.stageFlags = vk::ShaderStageFlagBits::eFragment,
+			.offset = 0,
+			.size = sizeof(PushConstants),
+		},
+	};
+
+	SpectrogramImage::SpectrogramImage(
+		SpectrogramLayout const &layout,
+		Gpu const &gpu,
+		vma::Allocator const &allocator
+	) : SpectrogramImage{
+		layout, gpu, allocator,
+		create_image(layout, allocator),
+		create_staging_buffer(layout, allocator)
+	} {}
+
+	SpectrogramImage::~SpectrogramImage() {
+		_allocator.freeMemory(_staging_allocation);
+		_allocator.freeMemory(_image_allocation);
+	}
+
+	void SpectrogramImage::commit_magnitudes() {
+		_committed = true;
+	}
+
+	void SpectrogramImage::record_upload(vk::raii::CommandBuffer const &command_buffer, uint32_t flight_frame) {
+		vk::ImageSubresourceRange const subresource_range{
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		};
+		// the image stays in the general layout, so rows can be copied in without transitioning the whole ring
+		if (!_initialized) {
+			vk::ImageMemoryBarrier to_general{
+				.srcAccessMask = {},
+				.dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+				.oldLayout = vk::ImageLayout::eUndefined,
+				.newLayout = vk::ImageLayout::eGeneral,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = *_image,
+				.subresourceRange = subresource_range,
+			};
+			command_buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {},
+				nullptr, nullptr, to_general);
+			command_buffer.clearColorImage(
+				*_image, vk::ImageLayout::eGeneral,
+				vk::ClearColorValue{.float32 = std::array{0.0f, 0.0f, 0.0f, 0.0f}}, subresource_range);
+			_initialized = true;
+		}
+		if (!_committed) return;
+		_committed = false;
+		// the timeline value of this flight frame has signaled, so nothing is reading this slot anymore
+		vk::DeviceSize const staging_offset = flight_frame * _column_stride;
+		std::ranges::copy(_column, _staging_data + staging_offset);
+		_allocator.flushAllocation(_staging_allocation, staging_offset, _column.size());
+		// earlier frames may still be sampling the ring
+		vk::ImageMemoryBarrier before_copy{
+			.srcAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferWrite,
+			.dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+			.oldLayout = vk::ImageLayout::eGeneral,
+			.newLayout = vk::ImageLayout::eGeneral,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = *_image,
+			.subresourceRange = subresource_range,
+		};
+		command_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eTransfer, {},
+			nullptr, nullptr, before_copy);
+		vk::BufferImageCopy buffer_image_copy{
+			.bufferOffset = staging_offset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource{
+				.aspectMask = vk::ImageAspectFlagBits::eColor,
+				.mipLevel = 0,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+			.imageOffset{.x = 0, .y = static_cast<int32_t>(_push_constants.head), .z = 0},
+			.imageExtent{.width = _push_constants.num_bins, .height = 1, .depth = 1},
+		};
+		command_buffer.copyBufferToImage(*_staging_buffer, *_image, vk::ImageLayout::eGeneral, buffer_image_copy);
+		vk::ImageMemoryBarrier after_copy{
+			.srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+			.dstAccessMask = vk::AccessFlagBits::eShaderRead,
+			.oldLayout = vk::ImageLayout::eGeneral,
+			.newLayout = vk::ImageLayout::eGeneral,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = *_image,
+			.subresourceRange = subresource_range,
+		};
+		command_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {},
+			nullptr, nullptr, after_copy);
+		++_push_constants.head;
+		if (_push_constants.head == _push_constants.num_rows) _push_constants.head = 0;
+	}
+
+	void SpectrogramImage::bind_and_draw(
+		vk::raii::CommandBuffer const &command_buffer,
+		vk::raii::PipelineLayout const &pipeline_layout
+	) const {
+		command_buffer.bindDescriptorSets(
+			vk::PipelineBindPoint::eGraphics, *pipeline_layout, 0, {*_descriptor_set}, nullptr);
+		command_buffer.pushConstants<PushConstants>(
+			*pipeline_layout, vk::ShaderStageFlagBits::eFragment, 0, _push_constants);
+		command_buffer.draw(3, 1, 0, 0); // fullscreen triangle, see spectrogram.vert
+	}
+
+	SpectrogramImage::SpectrogramImage(
+		SpectrogramLayout const &layout,
+		Gpu const &gpu,
+		vma::Allocator const &allocator,
+		std::pair<vk::Image, vma::Allocation> const &image_and_allocation,
+		std::tuple<vk::Buffer, vma::Allocation, void *> const &staging_objects
+	)
+		: magnitude_format{layout.magnitude_format}
+		, _push_constants{
+			.num_bins = layout.num_bins,
+			.bins_per_octave = layout.bins_per_octave,
+			.num_rows = layout.num_rows,
+			.head = 0,
+		}
+		, _allocator{allocator}
+		, _column(layout.num_bins * magnitude_size(layout.magnitude_format), std::byte{0}) // encodes 0 in every format
+		, _column_stride{get_column_stride(layout)}
+		, _image{gpu.device, image_and_allocation.first}
+		, _image_allocation{image_and_allocation.second}
+		, _image_view{create_image_view(gpu, *_image, layout.magnitude_format)}
+		, _sampler{create_sampler(gpu)}
+		, _staging_buffer{gpu.device, std::get<vk::Buffer>(staging_objects)}
+		, _staging_allocation{std::get<vma::Allocation>(staging_objects)}
+		, _staging_data{static_cast<std::byte *>(std::get<void *>(staging_objects))}
+		, _descriptor_set_layout{create_descriptor_set_layout(gpu)}
+		, _set_layouts{*_descriptor_set_layout}
+		, _pipeline_description{
+			.vertex_shader_file_name = constants::SPECTROGRAM_VERTEX_SHADER_FILE_NAME,
+			.fragment_shader_file_name = constants::SPECTROGRAM_FRAGMENT_SHADER_FILE_NAME,
+			.binding_descriptions = {},
+			.attribute_descriptions = {},
+			.topology = vk::PrimitiveTopology::eTriangleList,
+			.push_constant_ranges = push_constant_ranges,
+			.set_layouts = _set_layouts,
+		}
+		, _descriptor_pool{create_descriptor_pool(gpu)}
+		, _descriptor_set{create_descriptor_set(gpu, _descriptor_pool, _descriptor_set_layout, _image_view, _sampler)} {}
+
+	std::pair<vk::Image, vma::Allocation> SpectrogramImage::create_image(
+		SpectrogramLayout const &layout,
+		vma::Allocator const &allocator
+	) {
+		vk::ImageCreateInfo image_create_info{
+			.imageType = vk::ImageType::e2D,
+			.format = magnitude_vk_format(layout.magnitude_format),
+			.extent{.width = layout.num_bins, .height = layout.num_rows, .depth = 1},
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined,
+		};
+		vma::AllocationCreateInfo allocation_create_info{
+			.usage = vma::MemoryUsage::eAutoPreferDevice,
+		};
+		return allocator.createImage(image_create_info, allocation_create_info);
+	}
+
+	vk::raii::ImageView SpectrogramImage::create_image_view(Gpu const &gpu, vk::Image image, MagnitudeFormat format) {
+		vk::ImageViewCreateInfo image_view_create_info{
+			.image = image,
+			.viewType = vk::ImageViewType::e2D,
+			.format = magnitude_vk_format(format),
+			.components{},
+			.subresourceRange{
+				.aspectMask = vk::ImageAspectFlagBits::eColor,
+				.baseMipLevel = 0,
+				.levelCount = 1,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+		};
+		return {gpu.device, image_view_create_info};
+	}
+
+	vk::raii::Sampler SpectrogramImage::create_sampler(Gpu const &gpu) {
+		// the shader uses texelFetch, so filtering and addressing don't matter
+		vk::SamplerCreateInfo sampler_create_info{
+			.magFilter = vk::Filter::eNearest,
+			.minFilter = vk::Filter::eNearest,
+			.mipmapMode = vk::SamplerMipmapMode::eNearest,
+			.addressModeU = vk::SamplerAddressMode::eClampToEdge,
+			.addressModeV = vk::SamplerAddressMode::eRepeat,
+			.addressModeW = vk::SamplerAddressMode::eClampToEdge,
+		};
+		return {gpu.device, sampler_create_info};
+	}
+
+	vk::DeviceSize SpectrogramImage::get_column_stride(SpectrogramLayout const &layout) {
+		vk::DeviceSize column_size = layout.num_bins * magnitude_size(layout.magnitude_format);
+		return (column_size + 3) & ~vk::DeviceSize{3};
+	}
+
+	std::tuple<vk::Buffer, vma::Allocation, void *> SpectrogramImage::create_staging_buffer(
+		SpectrogramLayout const &layout,
+		vma::Allocator const &allocator
+	) {
+		vk::BufferCreateInfo buffer_create_info{
+			.size = constants::MAX_FRAMES_IN_FLIGHT * get_column_stride(layout),
+			.usage = vk::BufferUsageFlagBits::eTransferSrc,
+			.sharingMode = vk::SharingMode::eExclusive,
+		};
+		vma::AllocationCreateInfo allocation_create_info{
+			.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
+			.usage = vma::MemoryUsage::eAutoPreferHost,
+		};
+		vma::AllocationInfo allocation_info;
+		auto buffer_and_allocation = allocator.createBuffer(
+			buffer_create_info, allocation_create_info, &allocation_info);
+		return std::make_tuple(buffer_and_allocation.first, buffer_and_allocation.second, allocation_info.pMappedData);
+	}
+
+	vk::raii::DescriptorSetLayout SpectrogramImage::create_descriptor_set_layout(Gpu const &gpu) {
+		vk::DescriptorSetLayoutBinding descriptor_set_layout_binding{
+			.binding = 0,
+			.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eFragment,
+		};
+		vk::DescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{
+			.bindingCount = 1,
+			.pBindings = &descriptor_set_layout_binding,
+		};
+		return {gpu.device, descriptor_set_layout_create_info};
+	}
+
+	vk::raii::DescriptorPool SpectrogramImage::create_descriptor_pool(Gpu const &gpu) {
+		vk::DescriptorPoolSize descriptor_pool_size{
+			.type = vk::DescriptorType::eCombinedImageSampler,
+			.descriptorCount = 1,
+		};
+		vk::DescriptorPoolCreateInfo descriptor_pool_create_info{
+			// vk::raii::DescriptorSet frees itself
+			.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+			.maxSets = 1,
+			.poolSizeCount = 1,
+			.pPoolSizes = &descriptor_pool_size,
+		};
+		return {gpu.device, descriptor_pool_create_info};
+	}
+
+	vk::raii::DescriptorSet SpectrogramImage::create_descriptor_set(
+		Gpu const &gpu,
+		vk::raii::DescriptorPool const &descriptor_pool,
+		vk::raii::DescriptorSetLayout const &descriptor_set_layout,
+		vk::raii::ImageView const &image_view,
+		vk::raii::Sampler const &sampler
+	) {
+		vk::DescriptorSetAllocateInfo descriptor_set_allocate_info{
+			.descriptorPool = *descriptor_pool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &*descriptor_set_layout,
+		};
+		vk::raii::DescriptorSet descriptor_set{
+			std::move(vk::raii::DescriptorSets{gpu.device, descriptor_set_allocate_info}.front())};
+		vk::DescriptorImageInfo descriptor_image_info{
+			.sampler = *sampler,
+			.imageView = *image_view,
+			.imageLayout = vk::ImageLayout::eGeneral,
+		};
+		vk::WriteDescriptorSet write_descriptor_set{
+			.dstSet = *descriptor_set,
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+			.pImageInfo = &descriptor_image_info,
+		};
+		gpu.device.updateDescriptorSets(write_descriptor_set, nullptr);
+		return descriptor_set;
+	}
+} // av
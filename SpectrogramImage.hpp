@@ -0,0 +1,92 @@
+#ifndef AUDIO_VISUALIZER_SPECTROGRAMIMAGE_HPP
+#define AUDIO_VISUALIZER_SPECTROGRAMIMAGE_HPP
+
+#include "Gpu.hpp"
+#include "Layout.hpp"
+#include "MagnitudeEncoding.hpp"
+#include "PipelineDescription.hpp"
+#include "graphics_headers.hpp"
+#include <array>
+#include <span>
+#include <tuple>
+#include <vector>
+
+namespace av {
+	// scrolling spectrogram: a device-local ring image with one row per analysis frame
+	// every analysis frame, only the newest column of magnitudes is copied into the row at the ring head
+	// a fullscreen triangle then samples the ring, offset by the head so the newest row is at the top
+	class SpectrogramImage {
+	public:
+		SpectrogramImage(
+			SpectrogramLayout const &,
+			Gpu const &,
+			vma::Allocator const &
+		);
+		~SpectrogramImage();
+		// must be recorded outside of the render pass
+		void record_upload(vk::raii::CommandBuffer const &, uint32_t flight_frame);
+		void bind_and_draw(vk::raii::CommandBuffer const &, vk::raii::PipelineLayout const &) const;
+		// the next record_upload adds magnitude_data as a new row, frames drawn in between don't scroll
+		void commit_magnitudes();
+		// write the newest encoded magnitudes here (see encode_magnitudes), they are copied to the gpu in record_upload
+		std::span<std::byte> const &magnitude_data{_magnitude_data};
+		MagnitudeFormat const magnitude_format;
+		PipelineDescription const &pipeline_description{_pipeline_description};
+
+		struct PushConstants {
+			uint32_t num_bins;
+			uint32_t bins_per_octave;
+			uint32_t num_rows;
+			uint32_t head; // the row that will be written next, i.e. one past the newest row
+		};
+
+	private:
+		PushConstants _push_constants;
+		bool _initialized = false; // whether the image has been transitioned and cleared
+		bool _committed = false; // whether magnitude_data holds a row that hasn't been uploaded yet
+		vma::Allocator const &_allocator;
+		std::vector<std::byte> _column;
+		std::span<std::byte> const _magnitude_data{_column};
+		vk::DeviceSize const _column_stride; // in the staging buffer, rounded up to 4 bytes for the copy
+		vk::raii::Image const _image;
+		vma::Allocation const _image_allocation;
+		vk::raii::ImageView const _image_view;
+		vk::raii::Sampler const _sampler;
+		vk::raii::Buffer const _staging_buffer; // one column per frame in flight
+		vma::Allocation const _staging_allocation;
+		std::byte *const _staging_data;
+		vk::raii::DescriptorSetLayout const _descriptor_set_layout;
+		std::array<vk::DescriptorSetLayout, 1> const _set_layouts;
+		PipelineDescription const _pipeline_description; // after everything it points into
+		vk::raii::DescriptorPool const _descriptor_pool;
+		vk::raii::DescriptorSet const _descriptor_set;
+		SpectrogramImage(
+			SpectrogramLayout const &,
+			Gpu const &,
+			vma::Allocator const &,
+			std::pair<vk::Image, vma::Allocation> const &image_and_allocation,
+			std::tuple<vk::Buffer, vma::Allocation, void *> const &staging_objects
+		);
+		static std::pair<vk::Image, vma::Allocation> create_image(SpectrogramLayout const &, vma::Allocator const &);
+		static vk::raii::ImageView create_image_view(Gpu const &, vk::Image, MagnitudeFormat);
+		static vk::raii::Sampler create_sampler(Gpu const &);
+		static vk::DeviceSize get_column_stride(SpectrogramLayout const &);
+		static std::tuple<vk::Buffer, vma::Allocation, void *> create_staging_buffer(
+			SpectrogramLayout const &,
+			vma::Allocator const &
+		);
+		static vk::raii::DescriptorSetLayout create_descriptor_set_layout(Gpu const &);
+		static vk::raii::DescriptorPool create_descriptor_pool(Gpu const &);
+		static vk::raii::DescriptorSet create_descriptor_set(
+			Gpu const &,
+			vk::raii::DescriptorPool const &,
+			vk::raii::DescriptorSetLayout const &,
+			vk::raii::ImageView const &,
+			vk::raii::Sampler const &
+		);
+
+		static std::array<vk::PushConstantRange, 1> const push_constant_ranges;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_SPECTROGRAMIMAGE_HPP
@@ -0,0 +1,99 @@
+#ifndef AUDIO_VISUALIZER_SPECTRUMFILE_HPP
+#define AUDIO_VISUALIZER_SPECTRUMFILE_HPP
+
+// layout of the recordings written by SpectrumRecorder and replayed by SpectrumReplay
+// everything is in native byte order (little-endian on every platform this runs on)
+//
+// Header
+// double frequencies[num_bins]
+// padding up to chunks_offset
+// chunks: ChunkHeader followed by num_frames records of record_size bytes
+//	every chunk but the last holds frames_per_chunk records, so frame k is in chunk k / frames_per_chunk
+//	record: int64_t timestamp in nanoseconds, then num_bins magnitudes (float, uint8_t or uint16_t), padded to 8 bytes
+// IndexEntry index[num_chunks]
+// Footer
+//
+// a recording that was cut off (e.g. by a crash) has no index or footer,
+// the replay rebuilds the index by walking the chunk headers instead
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace av::spectrum_file {
+	static constexpr uint64_t MAGIC = 0x3130434550535641; // "AVSPEC01"
+	static constexpr uint64_t CHUNK_MAGIC = 0x4b4e554843505641; // "AVPCHUNK"
+	static constexpr uint64_t FOOTER_MAGIC = 0x58444e4943505641; // "AVPCINDX"
+	static constexpr uint32_t VERSION = 1;
+
+	static_assert(std::endian::native == std::endian::little, "recordings are little-endian");
+
+	enum class Quantization : uint32_t {
+		float32 = 0,
+		log8 = 1, // see LogQuantization.hpp
+		log16 = 2,
+	};
+
+	struct Header {
+		uint64_t magic;
+		uint32_t version;
+		Quantization quantization;
+		uint32_t num_bins;
+		uint32_t frames_per_chunk;
+		uint32_t record_size;
+		float sample_rate;
+		float floor_db; // only for the log quantizations
+		uint32_t reserved;
+		uint64_t chunks_offset;
+	};
+
+	struct ChunkHeader {
+		uint64_t magic;
+		uint64_t first_frame;
+		uint32_t num_frames;
+		uint32_t reserved;
+		int64_t first_timestamp_nanoseconds;
+	};
+
+	struct IndexEntry {
+		uint64_t first_frame;
+		int64_t first_timestamp_nanoseconds;
+		uint64_t offset; // of the ChunkHeader, from the start of the file
+	};
+
+	struct Footer {
+		uint64_t index_offset;
+		uint64_t num_chunks;
+		uint64_t num_frames;
+		uint64_t magic;
+	};
+
+	static constexpr size_t CHUNKS_ALIGNMENT = 4096; // so the first chunk starts on a page
+
+	inline size_t bytes_per_magnitude(Quantization quantization) {
+		switch (quantization) {
+			case Quantization::log8:
+				return 1;
+			case Quantization::log16:
+				return 2;
+			default:
+				return 4;
+		}
+	}
+
+	inline uint32_t record_size(uint32_t num_bins, Quantization quantization) {
+		size_t size = sizeof(int64_t) + num_bins * bytes_per_magnitude(quantization);
+		return static_cast<uint32_t>((size + 7) & ~size_t{7});
+	}
+
+	inline uint64_t chunks_offset(uint32_t num_bins) {
+		size_t end_of_frequencies = sizeof(Header) + num_bins * sizeof(double);
+		return (end_of_frequencies + CHUNKS_ALIGNMENT - 1) / CHUNKS_ALIGNMENT * CHUNKS_ALIGNMENT;
+	}
+
+	inline uint64_t chunk_size(Header const &header, uint32_t num_frames) {
+		return sizeof(ChunkHeader) + uint64_t{num_frames} * header.record_size;
+	}
+} // av
+
+#endif //AUDIO_VISUALIZER_SPECTRUMFILE_HPP
@@ -0,0 +1,93 @@
+#include "SpectrumPublisher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace av {
+	SpectrumPublisher::SpectrumPublisher(
+		std::string name_, std::span<long double const> frequencies, float sample_rate, uint32_t num_slots
+	)
+		: name{std::move(name_)}
+		, size{shared_spectrum::total_size(static_cast<uint32_t>(frequencies.size()), num_slots)}
+		, base{create_mapping(name, size)}
+		, header{*new(base) shared_spectrum::Header{}} {
+		auto num_bins = static_cast<uint32_t>(frequencies.size());
+		header.version = shared_spectrum::VERSION;
+		header.num_bins = num_bins;
+		header.num_slots = num_slots;
+		header.slot_size = shared_spectrum::slot_size(num_bins);
+		header.sample_rate.store(sample_rate, std::memory_order_relaxed);
+		header.frames_published.store(0, std::memory_order_relaxed);
+		std::ranges::copy(frequencies, reinterpret_cast<float *>(base + shared_spectrum::frequencies_offset()));
+		for (uint32_t i = 0; i < num_slots; ++i)
+			new(base + shared_spectrum::slots_offset(num_bins) + size_t{i} * header.slot_size) shared_spectrum::Slot{};
+		header.magic.store(shared_spectrum::MAGIC, std::memory_order_release);
+	}
+
+	void SpectrumPublisher::publish(int64_t timestamp_nanoseconds, std::span<float const> magnitudes) noexcept {
+		auto &slot = *reinterpret_cast<shared_spectrum::Slot *>(
+			base + shared_spectrum::slots_offset(header.num_bins)
+			+ (frames_published % header.num_slots) * header.slot_size);
+		// seqlock: odd while writing, readers that overlap with this will see the sequence change and retry
+		uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.frame_index = frames_published;
+		slot.timestamp_nanoseconds = timestamp_nanoseconds;
+		std::memcpy(reinterpret_cast<float *>(&slot + 1), magnitudes.data(), std::min<size_t>(magnitudes.size(), header.num_bins) * sizeof(float));
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+		header.frames_published.store(++frames_published, std::memory_order_release);
+	}
+
+	void SpectrumPublisher::set_sample_rate(float sample_rate) noexcept {
+		header.sample_rate.store(sample_rate, std::memory_order_relaxed);
+	}
+
+#if defined(__unix__)
+	std::byte *SpectrumPublisher::create_mapping(std::string const &name, size_t size) {
+		// never unlink someone else's object, readers of a running publisher would silently stop getting frames
+		int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+		if (fd == -1 && errno == EEXIST)
+			throw std::system_error(errno, std::generic_category(),
+			                        "shared memory " + name + " exists already (another publisher, or left over from a crash)");
+		if (fd == -1)
+			throw std::system_error(errno, std::generic_category(), "failed to create shared memory " + name);
+		if (ftruncate(fd, static_cast<off_t>(size)) == -1) {
+			int error = errno;
+			close(fd);
+			shm_unlink(name.c_str());
+			throw std::system_error(error, std::generic_category(), "failed to size shared memory " + name);
+		}
+		void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		int error = errno;
+		close(fd);
+		if (mapping == MAP_FAILED) {
+			shm_unlink(name.c_str());
+			throw std::system_error(error, std::generic_category(), "failed to map shared memory " + name);
+		}
+		return static_cast<std::byte *>(mapping);
+	}
+
+	SpectrumPublisher::~SpectrumPublisher() {
+		munmap(base, size);
+		shm_unlink(name.c_str());
+	}
+#else
+	std::byte *SpectrumPublisher::create_mapping(std::string const &, size_t) {
+		throw std::runtime_error("publishing the spectrum needs posix shared memory");
+	}
+
+	SpectrumPublisher::~SpectrumPublisher() = default;
+#endif
+} // av
@@ -0,0 +1,49 @@
+#ifndef AUDIO_VISUALIZER_SPECTRUMPUBLISHER_HPP
+#define AUDIO_VISUALIZER_SPECTRUMPUBLISHER_HPP
+
+#include "SharedSpectrum.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace av {
+	// writes every spectral frame into a posix shared memory ring (see SharedSpectrum.hpp)
+	// so other local processes can use it through SpectrumReader.hpp
+	// publishing never waits on readers
+	class SpectrumPublisher {
+	public:
+		static constexpr uint32_t DEFAULT_NUM_SLOTS = 64;
+
+		// name is a shm name like "/audio_visualizer_spectrum"
+		// throws if an object with that name exists already, which is another publisher
+		// or one left behind by a crash (remove it with rm /dev/shm/<name> on linux)
+		// only the object this created is unlinked again, on destruction
+		SpectrumPublisher(
+			std::string name, std::span<long double const> frequencies, float sample_rate,
+			uint32_t num_slots = DEFAULT_NUM_SLOTS
+		);
+
+		~SpectrumPublisher();
+
+		SpectrumPublisher(SpectrumPublisher const &) = delete;
+		SpectrumPublisher &operator=(SpectrumPublisher const &) = delete;
+
+		// magnitudes must hold one value per frequency
+		void publish(int64_t timestamp_nanoseconds, std::span<float const> magnitudes) noexcept;
+
+		// after switching to a capture device with another rate, the frequencies stay the same
+		void set_sample_rate(float) noexcept;
+
+	private:
+		std::string const name;
+		size_t const size;
+		std::byte *const base;
+		shared_spectrum::Header &header;
+		uint64_t frames_published = 0;
+
+		static std::byte *create_mapping(std::string const &name, size_t size);
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_SPECTRUMPUBLISHER_HPP
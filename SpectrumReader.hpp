@@ -0,0 +1,130 @@
+#ifndef AUDIO_VISUALIZER_SPECTRUMREADER_HPP
+#define AUDIO_VISUALIZER_SPECTRUMREADER_HPP
+
+// header-only reader for the spectrum that SpectrumPublisher puts in posix shared memory
+// any number of processes can read at the same time, none of them can stall the publisher
+//
+//	av::SpectrumReader reader{"/audio_visualizer_spectrum"};
+//	std::vector<float> magnitudes(reader.num_bins());
+//	if (auto frame = reader.read_latest(magnitudes)) ...
+//
+// link with -lrt on glibc older than 2.34
+
+#include "SharedSpectrum.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace av {
+	class SpectrumReader {
+	public:
+		struct FrameInfo {
+			uint64_t frame_index;
+			int64_t timestamp_nanoseconds;
+		};
+
+		// a publisher that died mid-write leaves its slot odd forever, so reads give up instead of spinning
+		static constexpr int MAX_ATTEMPTS = 64;
+
+		explicit SpectrumReader(char const *name) {
+			int fd = shm_open(name, O_RDONLY, 0);
+			if (fd == -1)
+				throw std::runtime_error(std::string("failed to open shared spectrum ") + name);
+			struct stat file_stat{};
+			if (fstat(fd, &file_stat) == -1 || static_cast<size_t>(file_stat.st_size) < sizeof(shared_spectrum::Header)) {
+				close(fd);
+				throw std::runtime_error("shared spectrum is not initialized yet");
+			}
+			size = static_cast<size_t>(file_stat.st_size);
+			void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+			close(fd);
+			if (mapping == MAP_FAILED)
+				throw std::runtime_error("failed to map shared spectrum");
+			base = static_cast<std::byte const *>(mapping);
+			if (header().magic.load(std::memory_order_acquire) != shared_spectrum::MAGIC
+			    || header().version != shared_spectrum::VERSION
+			    || !header().num_bins || !header().num_slots // read takes frame_index % num_slots
+			    || header().slot_size != shared_spectrum::slot_size(header().num_bins)
+			    || size < shared_spectrum::total_size(header().num_bins, header().num_slots)) {
+				munmap(mapping, size);
+				throw std::runtime_error("shared spectrum has an unknown format");
+			}
+		}
+
+		~SpectrumReader() {
+			munmap(const_cast<std::byte *>(base), size);
+		}
+
+		SpectrumReader(SpectrumReader const &) = delete;
+		SpectrumReader &operator=(SpectrumReader const &) = delete;
+
+		[[nodiscard]] uint32_t num_bins() const { return header().num_bins; }
+
+		// can change while reading, if the publisher switches capture devices
+		[[nodiscard]] float sample_rate() const { return header().sample_rate.load(std::memory_order_relaxed); }
+
+		// center frequency of each bin in hz
+		[[nodiscard]] std::span<float const> frequencies() const {
+			return {reinterpret_cast<float const *>(base + shared_spectrum::frequencies_offset()), num_bins()};
+		}
+
+		[[nodiscard]] uint64_t frames_published() const {
+			return header().frames_published.load(std::memory_order_acquire);
+		}
+
+		// copies the newest frame into magnitudes, which must hold num_bins() floats
+		// nullopt if nothing has been published yet, or no consistent copy came out of MAX_ATTEMPTS tries
+		std::optional<FrameInfo> read_latest(std::span<float> magnitudes) const {
+			for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+				uint64_t published = frames_published();
+				if (!published) return std::nullopt;
+				if (auto frame = read(published - 1, magnitudes)) return frame;
+			}
+			return std::nullopt;
+		}
+
+		// copies a specific frame, to consume every frame in order
+		// nullopt if it has not been published yet, has already been overwritten,
+		// or stayed mid-write for MAX_ATTEMPTS tries
+		std::optional<FrameInfo> read(uint64_t frame_index, std::span<float> magnitudes) const {
+			if (magnitudes.size() < num_bins())
+				throw std::length_error("magnitudes must hold num_bins() floats");
+			if (frame_index >= frames_published()) return std::nullopt;
+			auto const &slot = *reinterpret_cast<shared_spectrum::Slot const *>(
+				base + shared_spectrum::slots_offset(num_bins())
+				+ (frame_index % header().num_slots) * header().slot_size);
+			auto const *slot_magnitudes = reinterpret_cast<float const *>(&slot + 1);
+			for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+				uint64_t sequence_before = slot.sequence.load(std::memory_order_acquire);
+				if (sequence_before & 1) continue; // being written right now
+				FrameInfo frame_info{slot.frame_index, slot.timestamp_nanoseconds};
+				std::memcpy(magnitudes.data(), slot_magnitudes, num_bins() * sizeof(float));
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot.sequence.load(std::memory_order_relaxed) != sequence_before) continue; // torn
+				if (frame_info.frame_index != frame_index) return std::nullopt;
+				return frame_info;
+			}
+			return std::nullopt;
+		}
+
+	private:
+		std::byte const *base;
+		size_t size;
+
+		[[nodiscard]] shared_spectrum::Header const &header() const {
+			return *reinterpret_cast<shared_spectrum::Header const *>(base);
+		}
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_SPECTRUMREADER_HPP
@@ -0,0 +1,147 @@
+#include "SpectrumRecorder.hpp"
+
+#include "LogQuantization.hpp"
+#include "Trace.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace av {
+	SpectrumRecorder::SpectrumRecorder(
+		char const *file_name, std::span<long double const> frequencies, float sample_rate,
+		SpectrumRecordingOptions const &options
+	)
+		: file{file_name, std::ios::binary | std::ios::trunc}
+		, header{create_header(static_cast<uint32_t>(frequencies.size()), sample_rate, options)}
+		, queue{options.queue_capacity, Frame{0, std::vector<float>(frequencies.size())}}
+		, chunk(spectrum_file::chunk_size(header, header.frames_per_chunk)) {
+		if (!file)
+			throw std::runtime_error(std::string("failed to open ") + file_name + " for recording");
+		std::vector<std::byte> head(header.chunks_offset);
+		std::memcpy(head.data(), &header, sizeof(header));
+		for (size_t i = 0; i < frequencies.size(); ++i) {
+			auto frequency = static_cast<double>(frequencies[i]);
+			std::memcpy(head.data() + sizeof(header) + i * sizeof(double), &frequency, sizeof(double));
+		}
+		file.write(reinterpret_cast<char const *>(head.data()), static_cast<std::streamsize>(head.size()));
+		thread = std::thread(&SpectrumRecorder::run, this);
+	}
+
+	SpectrumRecorder::~SpectrumRecorder() {
+		queue.close();
+		thread.join();
+		if (frames_in_chunk) write_chunk();
+		spectrum_file::Footer footer{
+			.index_offset = static_cast<uint64_t>(file.tellp()),
+			.num_chunks = index.size(),
+			.num_frames = frames_written,
+			.magic = spectrum_file::FOOTER_MAGIC,
+		};
+		file.write(
+			reinterpret_cast<char const *>(index.data()),
+			static_cast<std::streamsize>(index.size() * sizeof(spectrum_file::IndexEntry))
+		);
+		file.write(reinterpret_cast<char const *>(&footer), sizeof(footer));
+	}
+
+	spectrum_file::Header SpectrumRecorder::create_header(
+		uint32_t num_bins, float sample_rate, SpectrumRecordingOptions const &options
+	) {
+		if (!options.frames_per_chunk)
+			throw std::invalid_argument("frames_per_chunk must be positive");
+		return spectrum_file::Header{
+			.magic = spectrum_file::MAGIC,
+			.version = spectrum_file::VERSION,
+			.quantization = options.quantization,
+			.num_bins = num_bins,
+			.frames_per_chunk = options.frames_per_chunk,
+			.record_size = spectrum_file::record_size(num_bins, options.quantization),
+			.sample_rate = sample_rate,
+			.floor_db = options.floor_db,
+			.reserved = 0,
+			.chunks_offset = spectrum_file::chunks_offset(num_bins),
+		};
+	}
+
+	bool SpectrumRecorder::record(
+		int64_t timestamp_nanoseconds, std::span<float const> magnitudes, float gain
+	) noexcept {
+		Frame *frame = queue.begin_push();
+		if (!frame) return false;
+		frame->timestamp_nanoseconds = timestamp_nanoseconds;
+		size_t num_bins = std::min(magnitudes.size(), frame->magnitudes.size());
+		for (size_t i = 0; i < num_bins; ++i)
+			frame->magnitudes[i] = magnitudes[i] * gain;
+		queue.end_push();
+		return true;
+	}
+
+	void SpectrumRecorder::run() {
+		AV_TRACE_THREAD("recording");
+		while (queue.wait_for_push()) {
+			while (Frame *frame = queue.front()) {
+				write_record(*frame);
+				queue.pop();
+				if (frames_in_chunk == header.frames_per_chunk) write_chunk();
+			}
+		}
+	}
+
+	void SpectrumRecorder::write_record(Frame const &frame) {
+		using Quantization = spectrum_file::Quantization;
+		if (!frames_in_chunk) {
+			spectrum_file::ChunkHeader chunk_header{
+				.magic = spectrum_file::CHUNK_MAGIC,
+				.first_frame = frames_written,
+				.num_frames = 0, // filled in by write_chunk
+				.reserved = 0,
+				.first_timestamp_nanoseconds = frame.timestamp_nanoseconds,
+			};
+			std::memcpy(chunk.data(), &chunk_header, sizeof(chunk_header));
+		}
+		std::byte *record = chunk.data() + sizeof(spectrum_file::ChunkHeader) + frames_in_chunk * header.record_size;
+		std::memset(record, 0, header.record_size);
+		std::memcpy(record, &frame.timestamp_nanoseconds, sizeof(int64_t));
+		std::byte *magnitudes = record + sizeof(int64_t);
+		switch (header.quantization) {
+			case Quantization::log8:
+				for (size_t i = 0; i < header.num_bins; ++i)
+					magnitudes[i] = std::byte(log_quantization::quantize(frame.magnitudes[i], header.floor_db, 0xff));
+				break;
+			case Quantization::log16:
+				for (size_t i = 0; i < header.num_bins; ++i) {
+					auto value = static_cast<uint16_t>(
+						log_quantization::quantize(frame.magnitudes[i], header.floor_db, 0xffff));
+					std::memcpy(magnitudes + i * sizeof(uint16_t), &value, sizeof(uint16_t));
+				}
+				break;
+			default:
+				std::memcpy(magnitudes, frame.magnitudes.data(), header.num_bins * sizeof(float));
+		}
+		++frames_in_chunk;
+		++frames_written;
+	}
+
+	void SpectrumRecorder::write_chunk() {
+		AV_TRACE_SCOPE("write chunk");
+		auto &chunk_header = *reinterpret_cast<spectrum_file::ChunkHeader *>(chunk.data());
+		chunk_header.num_frames = frames_in_chunk;
+		index.emplace_back(spectrum_file::IndexEntry{
+			.first_frame = chunk_header.first_frame,
+			.first_timestamp_nanoseconds = chunk_header.first_timestamp_nanoseconds,
+			.offset = static_cast<uint64_t>(file.tellp()),
+		});
+		file.write(
+			reinterpret_cast<char const *>(chunk.data()),
+			static_cast<std::streamsize>(spectrum_file::chunk_size(header, frames_in_chunk))
+		);
+		file.flush(); // so a crash loses at most the chunk in progress
+		if (!file) {
+			std::cerr << "warning: failed to write the spectrum recording" << std::endl;
+			file.clear();
+		}
+		frames_in_chunk = 0;
+	}
+} // av
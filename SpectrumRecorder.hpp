@@ -0,0 +1,69 @@
+#ifndef AUDIO_VISUALIZER_SPECTRUMRECORDER_HPP
+#define AUDIO_VISUALIZER_SPECTRUMRECORDER_HPP
+
+#include "SpectrumFile.hpp"
+#include "SpscQueue.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace av {
+	struct SpectrumRecordingOptions {
+		spectrum_file::Quantization quantization = spectrum_file::Quantization::float32;
+		float floor_db = -60.0f;
+		uint32_t frames_per_chunk = 256;
+		size_t queue_capacity = 64; // frames, newer ones are dropped if the disk can't keep up
+	};
+
+	// writes spectral frames to a file (see SpectrumFile.hpp) from a background thread
+	// record() only copies into a lock-free queue
+	class SpectrumRecorder {
+	public:
+		SpectrumRecorder(
+			char const *file_name, std::span<long double const> frequencies, float sample_rate,
+			SpectrumRecordingOptions const &
+		);
+
+		// writes what's left in the queue, then the index
+		~SpectrumRecorder();
+
+		SpectrumRecorder(SpectrumRecorder const &) = delete;
+		SpectrumRecorder &operator=(SpectrumRecorder const &) = delete;
+
+		// every magnitude is multiplied by gain on the way into the queue (e.g. to normalize)
+		// false if the queue was full and the frame got dropped
+		bool record(int64_t timestamp_nanoseconds, std::span<float const> magnitudes, float gain = 1.0f) noexcept;
+
+	private:
+		struct Frame {
+			int64_t timestamp_nanoseconds;
+			std::vector<float> magnitudes;
+		};
+
+		std::ofstream file;
+		spectrum_file::Header const header;
+		SpscQueue<Frame> queue;
+		std::thread thread;
+
+		// only touched by the writer thread
+		std::vector<std::byte> chunk;
+		uint32_t frames_in_chunk = 0;
+		uint64_t frames_written = 0;
+		std::vector<spectrum_file::IndexEntry> index;
+
+		static spectrum_file::Header create_header(
+			uint32_t num_bins, float sample_rate, SpectrumRecordingOptions const &
+		);
+
+		void run();
+
+		void write_record(Frame const &);
+
+		void write_chunk();
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_SPECTRUMRECORDER_HPP
@@ -0,0 +1,171 @@
+#include "SpectrumReplay.hpp"
+
+#include "LogQuantization.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace av {
+#if defined(__unix__)
+	SpectrumReplay::SpectrumReplay(char const *file_name) {
+		int fd = open(file_name, O_RDONLY);
+		if (fd == -1)
+			throw std::runtime_error(std::string("failed to open recording ") + file_name);
+		struct stat file_stat{};
+		if (fstat(fd, &file_stat) == -1) {
+			close(fd);
+			throw std::runtime_error(std::string("failed to stat recording ") + file_name);
+		}
+		size = static_cast<size_t>(file_stat.st_size);
+		void *mapping = size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+		close(fd);
+		if (mapping == MAP_FAILED)
+			throw std::runtime_error(std::string("failed to map recording ") + file_name);
+		base = static_cast<std::byte const *>(mapping);
+		madvise(mapping, size, MADV_SEQUENTIAL); // replay mostly walks forward
+		try {
+			load_index();
+		} catch (...) {
+			munmap(mapping, size);
+			throw;
+		}
+	}
+
+	SpectrumReplay::~SpectrumReplay() {
+		munmap(const_cast<std::byte *>(base), size);
+	}
+#else
+	SpectrumReplay::SpectrumReplay(char const *) {
+		throw std::runtime_error("replay needs posix mmap");
+	}
+
+	SpectrumReplay::~SpectrumReplay() = default;
+#endif
+
+	void SpectrumReplay::load_index() {
+		using namespace spectrum_file;
+		if (size < sizeof(Header) || header().magic != MAGIC || header().version != VERSION
+		    || !header().frames_per_chunk
+		    || header().record_size != record_size(header().num_bins, header().quantization)
+		    || header().chunks_offset != chunks_offset(header().num_bins) || size < header().chunks_offset)
+			throw std::runtime_error("not a spectrum recording, or one from a different version");
+
+		if (load_footer_index()) return;
+
+		// cut off before the index was written (or the footer is damaged), walk the chunks instead
+		uint64_t offset = header().chunks_offset;
+		while (size - offset >= sizeof(ChunkHeader)) {
+			ChunkHeader chunk_header{};
+			std::memcpy(&chunk_header, base + offset, sizeof(ChunkHeader));
+			// every chunk before this one has to be full, record() relies on it
+			if (chunk_header.magic != CHUNK_MAGIC || chunk_header.first_frame != _num_frames
+			    || chunk_header.first_frame != index.size() * uint64_t{header().frames_per_chunk}
+			    || chunk_header.num_frames > header().frames_per_chunk
+			    || chunk_size(header(), chunk_header.num_frames) > size - offset)
+				break;
+			index.emplace_back(IndexEntry{
+				.first_frame = chunk_header.first_frame,
+				.first_timestamp_nanoseconds = chunk_header.first_timestamp_nanoseconds,
+				.offset = offset,
+			});
+			_num_frames += chunk_header.num_frames;
+			offset += chunk_size(header(), chunk_header.num_frames);
+		}
+	}
+
+	// every check is written so it can't overflow, the footer may be anything
+	bool SpectrumReplay::load_footer_index() {
+		using namespace spectrum_file;
+		if (size - header().chunks_offset < sizeof(Footer)) return false;
+		Footer footer{};
+		std::memcpy(&footer, base + size - sizeof(Footer), sizeof(Footer));
+		if (footer.magic != FOOTER_MAGIC) return false;
+		uint64_t const frames_per_chunk = header().frames_per_chunk;
+		if (footer.num_chunks != footer.num_frames / frames_per_chunk + (footer.num_frames % frames_per_chunk != 0))
+			return false;
+		uint64_t const index_end = size - sizeof(Footer);
+		if (footer.index_offset < header().chunks_offset || footer.index_offset > index_end
+		    || footer.num_chunks > (index_end - footer.index_offset) / sizeof(IndexEntry))
+			return false;
+		std::vector<IndexEntry> entries(footer.num_chunks);
+		std::memcpy(entries.data(), base + footer.index_offset, footer.num_chunks * sizeof(IndexEntry));
+		for (uint64_t i = 0; i < entries.size(); ++i) {
+			uint64_t const first_frame = i * frames_per_chunk; // less than num_frames, so no overflow
+			auto const num_frames = static_cast<uint32_t>(std::min(frames_per_chunk, footer.num_frames - first_frame));
+			// the chunks sit between chunks_offset and the index
+			if (entries[i].first_frame != first_frame || entries[i].offset < header().chunks_offset
+			    || entries[i].offset > footer.index_offset
+			    || chunk_size(header(), num_frames) > footer.index_offset - entries[i].offset)
+				return false;
+		}
+		index = std::move(entries);
+		_num_frames = footer.num_frames;
+		return true;
+	}
+
+	std::span<double const> SpectrumReplay::frequencies() const {
+		return {reinterpret_cast<double const *>(base + sizeof(spectrum_file::Header)), num_bins()};
+	}
+
+	std::byte const *SpectrumReplay::record(uint64_t frame) const {
+		if (frame >= _num_frames)
+			throw std::out_of_range("frame is past the end of the recording");
+		spectrum_file::IndexEntry const &chunk = index[frame / header().frames_per_chunk];
+		return base + chunk.offset + sizeof(spectrum_file::ChunkHeader)
+		       + (frame - chunk.first_frame) * header().record_size;
+	}
+
+	int64_t SpectrumReplay::timestamp(uint64_t frame) const {
+		int64_t timestamp_nanoseconds;
+		std::memcpy(&timestamp_nanoseconds, record(frame), sizeof(int64_t));
+		return timestamp_nanoseconds;
+	}
+
+	uint64_t SpectrumReplay::frame_at(int64_t timestamp_nanoseconds) const {
+		if (!_num_frames) throw std::out_of_range("the recording is empty");
+		// binary search the chunks, then the records in the chunk
+		auto chunk = std::ranges::upper_bound(
+			index, timestamp_nanoseconds, {}, &spectrum_file::IndexEntry::first_timestamp_nanoseconds);
+		if (chunk == index.begin()) return 0;
+		--chunk;
+		uint64_t lo = chunk->first_frame, hi = std::min(_num_frames, lo + header().frames_per_chunk);
+		while (hi - lo > 1) {
+			uint64_t mid = lo + (hi - lo) / 2;
+			(timestamp(mid) <= timestamp_nanoseconds ? lo : hi) = mid;
+		}
+		return lo;
+	}
+
+	void SpectrumReplay::read(uint64_t frame, std::span<float> magnitudes) const {
+		using Quantization = spectrum_file::Quantization;
+		if (magnitudes.size() < num_bins())
+			throw std::length_error("magnitudes must hold num_bins() floats");
+		std::byte const *values = record(frame) + sizeof(int64_t);
+		switch (header().quantization) {
+			case Quantization::log8:
+				for (size_t i = 0; i < num_bins(); ++i)
+					magnitudes[i] = log_quantization::dequantize(
+						std::to_integer<uint32_t>(values[i]), header().floor_db, 0xff);
+				break;
+			case Quantization::log16:
+				for (size_t i = 0; i < num_bins(); ++i) {
+					uint16_t value;
+					std::memcpy(&value, values + i * sizeof(uint16_t), sizeof(uint16_t));
+					magnitudes[i] = log_quantization::dequantize(value, header().floor_db, 0xffff);
+				}
+				break;
+			default:
+				std::memcpy(magnitudes.data(), values, num_bins() * sizeof(float));
+		}
+	}
+} // av
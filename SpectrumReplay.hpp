@@ -0,0 +1,56 @@
+#ifndef AUDIO_VISUALIZER_SPECTRUMREPLAY_HPP
+#define AUDIO_VISUALIZER_SPECTRUMREPLAY_HPP
+
+#include "SpectrumFile.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace av {
+	// maps a recording (see SpectrumFile.hpp) into memory and reads frames straight out of it
+	// nothing is decoded up front, so opening and seeking are instant no matter how long the recording is
+	class SpectrumReplay {
+	public:
+		explicit SpectrumReplay(char const *file_name);
+
+		~SpectrumReplay();
+
+		SpectrumReplay(SpectrumReplay const &) = delete;
+		SpectrumReplay &operator=(SpectrumReplay const &) = delete;
+
+		[[nodiscard]] uint32_t num_bins() const { return header().num_bins; }
+
+		[[nodiscard]] float sample_rate() const { return header().sample_rate; }
+
+		[[nodiscard]] std::span<double const> frequencies() const;
+
+		[[nodiscard]] uint64_t num_frames() const { return _num_frames; }
+
+		[[nodiscard]] int64_t timestamp(uint64_t frame) const;
+
+		// the last frame at or before timestamp_nanoseconds (clamped to the recording)
+		[[nodiscard]] uint64_t frame_at(int64_t timestamp_nanoseconds) const;
+
+		// magnitudes must hold num_bins() floats
+		void read(uint64_t frame, std::span<float> magnitudes) const;
+
+	private:
+		std::byte const *base = nullptr;
+		size_t size = 0;
+		std::vector<spectrum_file::IndexEntry> index;
+		uint64_t _num_frames = 0;
+
+		[[nodiscard]] spectrum_file::Header const &header() const {
+			return *reinterpret_cast<spectrum_file::Header const *>(base);
+		}
+
+		[[nodiscard]] std::byte const *record(uint64_t frame) const;
+
+		void load_index();
+		// false if the footer is missing or doesn't match the chunks, then load_index walks them instead
+		bool load_footer_index();
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_SPECTRUMREPLAY_HPP
@@ -0,0 +1,87 @@
+#ifndef AUDIO_VISUALIZER_SPSCQUEUE_HPP
+#define AUDIO_VISUALIZER_SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace av {
+	// bounded lock-free queue for exactly one producer thread and one consumer thread
+	// the slots are allocated up front and reused, so T can own buffers (e.g. a vector that is never resized)
+	// and neither side allocates after construction
+	template<typename T>
+	class SpscQueue {
+	public:
+		SpscQueue(size_t capacity, T const &prototype) : slots(capacity + 1, prototype) {}
+
+		// producer: the slot to fill in, or nullptr if the queue is full
+		T *begin_push() noexcept {
+			size_t tail = _tail.load(std::memory_order_relaxed);
+			if (next(tail) == _head.load(std::memory_order_acquire)) return nullptr;
+			return &slots[tail];
+		}
+
+		// producer: publish the slot from begin_push
+		void end_push() noexcept {
+			_tail.store(next(_tail.load(std::memory_order_relaxed)), std::memory_order_release);
+			_signal.fetch_add(1, std::memory_order_release);
+			_signal.notify_one();
+		}
+
+		// consumer: the oldest slot, or nullptr if the queue is empty
+		T *front() noexcept {
+			size_t head = _head.load(std::memory_order_relaxed);
+			if (head == _tail.load(std::memory_order_acquire)) return nullptr;
+			return &slots[head];
+		}
+
+		// consumer: release the slot from front back to the producer
+		void pop() noexcept {
+			_head.store(next(_head.load(std::memory_order_relaxed)), std::memory_order_release);
+		}
+
+		// consumer: pop everything but the newest slot, for consumers that only care about the latest value
+		// returns how many slots were dropped
+		size_t skip_to_newest() noexcept {
+			size_t head = _head.load(std::memory_order_relaxed);
+			size_t tail = _tail.load(std::memory_order_acquire);
+			if (head == tail) return 0;
+			size_t newest = tail == 0 ? slots.size() - 1 : tail - 1;
+			_head.store(newest, std::memory_order_release);
+			return (newest + slots.size() - head) % slots.size();
+		}
+
+		// consumer: sleep until something is pushed
+		// false once the queue is closed and there's nothing left to pop
+		bool wait_for_push() noexcept {
+			for (;;) {
+				uint32_t signal = _signal.load(std::memory_order_acquire);
+				if (front()) return true;
+				if (_closed.load(std::memory_order_acquire)) return false;
+				_signal.wait(signal, std::memory_order_acquire);
+			}
+		}
+
+		// producer: no more pushes, wakes the consumer so it can finish
+		void close() noexcept {
+			_closed.store(true, std::memory_order_release);
+			_signal.fetch_add(1, std::memory_order_release);
+			_signal.notify_all();
+		}
+
+	private:
+		// head and tail on separate cache lines so the two threads don't keep stealing each other's line
+		static constexpr size_t CACHE_LINE_SIZE = 64;
+		std::vector<T> slots;
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> _head{0};
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> _tail{0};
+		std::atomic<uint32_t> _signal{0}; // bumped on every push so the consumer can futex-wait on it
+		std::atomic<bool> _closed{false};
+
+		[[nodiscard]] size_t next(size_t index) const noexcept { return index + 1 == slots.size() ? 0 : index + 1; }
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_SPSCQUEUE_HPP
@@ -8,13 +8,24 @@ namespace av {
 	SurfaceInfo::SurfaceInfo(
 		vk::raii::SurfaceKHR const &surface,
 		Gpu const &gpu,
-		std::tuple<size_t, size_t> const &framebuffer_size
+		std::tuple<size_t, size_t> const &framebuffer_size,
+		LatencyPolicy latency_policy
 	)
 		: surface_capabilities{gpu.physical_device.getSurfaceCapabilitiesKHR(*surface)}
 		, surface_format{choose_surface_format(surface, gpu)}
-		, present_mode{choose_present_mode(surface, gpu)}
+		, present_mode{choose_present_mode(surface, gpu, latency_policy)}
+		, image_count{choose_image_count(surface_capabilities, present_mode, latency_policy)}
 		, extent{get_extent(surface_capabilities, framebuffer_size)} {}
 
+	size_t get_queue_depth(vk::PresentModeKHR present_mode, size_t swapchain_image_count, size_t frames_in_flight) {
+		// fifo shows every presented image in turn, so all but the one on screen can be waiting,
+		// acquiring blocks beyond that no matter how many frames are in flight
+		if (present_mode == vk::PresentModeKHR::eFifo || present_mode == vk::PresentModeKHR::eFifoRelaxed)
+			return std::max<size_t>(swapchain_image_count - 1, 1);
+		// mailbox and immediate never wait on the display, only the frames still on the gpu are queued
+		return frames_in_flight;
+	}
+
 	vk::SurfaceFormatKHR SurfaceInfo::choose_surface_format(
 		vk::raii::SurfaceKHR const &surface,
 		Gpu const &gpu
@@ -31,15 +42,41 @@ namespace av {
 
 	vk::PresentModeKHR SurfaceInfo::choose_present_mode(
 		vk::raii::SurfaceKHR const &surface,
-		Gpu const &gpu
+		Gpu const &gpu,
+		LatencyPolicy latency_policy
 	) {
 		auto present_modes = gpu.physical_device.getSurfacePresentModesKHR(*surface);
 		if (present_modes.empty())
 			throw std::runtime_error("Vulkan failed to find present modes");
-		for (vk::PresentModeKHR const &present_mode : present_modes)
-			if (present_mode == vk::PresentModeKHR::eMailbox)
-				return present_mode;
-		return vk::PresentModeKHR::eFifo; // try different modes
+		auto supports = [&present_modes](vk::PresentModeKHR present_mode) {
+			return std::ranges::find(present_modes, present_mode) != present_modes.end();
+		};
+		switch (latency_policy) {
+			case LatencyPolicy::lowest_latency:
+				if (supports(vk::PresentModeKHR::eMailbox)) return vk::PresentModeKHR::eMailbox;
+				if (supports(vk::PresentModeKHR::eImmediate)) return vk::PresentModeKHR::eImmediate;
+				break;
+			case LatencyPolicy::smooth:
+				if (supports(vk::PresentModeKHR::eMailbox)) return vk::PresentModeKHR::eMailbox;
+				break;
+			case LatencyPolicy::power_saving:
+				break;
+		}
+		return vk::PresentModeKHR::eFifo; // always supported
+	}
+
+	uint32_t SurfaceInfo::choose_image_count(
+		vk::SurfaceCapabilitiesKHR const &surface_capabilities,
+		vk::PresentModeKHR present_mode,
+		LatencyPolicy latency_policy
+	) {
+		// mailbox needs a spare image to replace, otherwise acquiring waits on the display like fifo
+		// smooth also keeps one spare with fifo so a late frame doesn't block the next acquire
+		bool spare = present_mode == vk::PresentModeKHR::eMailbox || latency_policy == LatencyPolicy::smooth;
+		uint32_t image_count = surface_capabilities.minImageCount + spare;
+		if (surface_capabilities.maxImageCount) // 0 means no limit
+			image_count = std::min(image_count, surface_capabilities.maxImageCount);
+		return image_count;
 	}
 
 	vk::Extent2D SurfaceInfo::get_extent(
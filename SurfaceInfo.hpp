@@ -2,6 +2,7 @@
 #define AUDIO_VISUALIZER_SURFACEINFO_HPP
 
 #include "Gpu.hpp"
+#include "LatencyPolicy.hpp"
 #include "graphics_headers.hpp"
 #include <tuple>
 
@@ -10,11 +11,13 @@ namespace av {
 		SurfaceInfo(
 			vk::raii::SurfaceKHR const &,
 			Gpu const &,
-			std::tuple<size_t, size_t> const &framebuffer_size
+			std::tuple<size_t, size_t> const &framebuffer_size,
+			LatencyPolicy
 		);
 		vk::SurfaceCapabilitiesKHR const surface_capabilities;
 		vk::SurfaceFormatKHR const surface_format;
 		vk::PresentModeKHR const present_mode;
+		uint32_t const image_count; // requested, the driver may create more
 		vk::Extent2D const extent;
 
 	private:
@@ -24,13 +27,22 @@ namespace av {
 		);
 		static vk::PresentModeKHR choose_present_mode(
 			vk::raii::SurfaceKHR const &,
-			Gpu const &
+			Gpu const &,
+			LatencyPolicy
+		);
+		static uint32_t choose_image_count(
+			vk::SurfaceCapabilitiesKHR const &,
+			vk::PresentModeKHR,
+			LatencyPolicy
 		);
 		static vk::Extent2D get_extent(
 			vk::SurfaceCapabilitiesKHR const &,
 			std::tuple<size_t, size_t> const &framebuffer_size
 		);
 	};
+
+	// frames that can be waiting between recording and scanout, the one place this rule lives
+	[[nodiscard]] size_t get_queue_depth(vk::PresentModeKHR, size_t swapchain_image_count, size_t frames_in_flight);
 } // av
 
 #endif //AUDIO_VISUALIZER_SURFACEINFO_HPP
@@ -0,0 +1,162 @@
+#ifdef AV_TRACE
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace av::trace {
+	namespace {
+		struct Event {
+			char const *name;
+			int64_t begin_nanoseconds;
+			int64_t end_nanoseconds;
+		};
+
+		// power of two so the ring index is a mask
+		constexpr size_t EVENTS_PER_THREAD = size_t{1} << 16;
+
+		struct ThreadBuffer {
+			uint32_t thread_id;
+			std::atomic<char const *> name{nullptr};
+			std::atomic<uint64_t> num_written{0}; // total, not wrapped
+			std::array<Event, EVENTS_PER_THREAD> events;
+		};
+
+		std::chrono::steady_clock::time_point const epoch = std::chrono::steady_clock::now();
+
+		// buffers are never freed so that events from exited threads still get dumped
+		std::mutex registry_mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+		std::atomic<bool> dump_requested{false};
+		char const *signal_file_name = nullptr;
+
+		int64_t now() noexcept {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - epoch).count();
+		}
+
+		thread_local ThreadBuffer *current_buffer = nullptr;
+
+		ThreadBuffer *register_buffer() {
+			std::lock_guard lock{registry_mutex};
+			auto &new_buffer = registry.emplace_back(std::make_unique<ThreadBuffer>());
+			new_buffer->thread_id = registry.size();
+			return new_buffer.get();
+		}
+
+		ThreadBuffer &thread_buffer() {
+			if (!current_buffer)
+				current_buffer = register_buffer();
+			return *current_buffer;
+		}
+
+		void write_string(std::ostream &out, char const *string) {
+			out << '"';
+			for (char const *c = string; *c; ++c) {
+				if (*c == '"' || *c == '\\') out << '\\';
+				out << *c;
+			}
+			out << '"';
+		}
+
+		extern "C" void handle_signal(int) {
+			dump_requested.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	Scope::Scope(char const *name) noexcept
+		: name{name}
+		, begin_nanoseconds{now()} {}
+
+	Scope::~Scope() {
+		int64_t end_nanoseconds = now();
+		ThreadBuffer &buffer = thread_buffer();
+		// only this thread writes num_written
+		uint64_t index = buffer.num_written.load(std::memory_order_relaxed);
+		buffer.events[index & (EVENTS_PER_THREAD - 1)] = {name, begin_nanoseconds, end_nanoseconds};
+		buffer.num_written.store(index + 1, std::memory_order_release);
+	}
+
+	void name_thread(char const *name) {
+		thread_buffer().name.store(name, std::memory_order_relaxed);
+	}
+
+	Thread::Thread(char const *name)
+		: buffer{register_buffer()} {
+		static_cast<ThreadBuffer *>(buffer)->name.store(name, std::memory_order_relaxed);
+	}
+
+	void Thread::bind() const noexcept {
+		current_buffer = static_cast<ThreadBuffer *>(buffer);
+	}
+
+	void dump(char const *file_name) {
+		std::ofstream file(file_name);
+		if (!file.is_open())
+			throw std::ios::failure("failed to open trace file");
+		file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		bool first = true;
+		std::vector<Event> events;
+		std::lock_guard lock{registry_mutex};
+		for (auto const &buffer : registry) {
+			if (char const *name = buffer->name.load(std::memory_order_relaxed)) {
+				file << (first ? "\n" : ",\n")
+				     << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->thread_id
+				     << R"(,"args":{"name":)";
+				write_string(file, name);
+				file << "}}";
+				first = false;
+			}
+			// like a seqlock: copy, then check how far the writer got in the meantime
+			uint64_t end = buffer->num_written.load(std::memory_order_acquire);
+			uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+			events.clear();
+			for (uint64_t i = begin; i < end; ++i)
+				events.push_back(buffer->events[i & (EVENTS_PER_THREAD - 1)]);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t written_since = buffer->num_written.load(std::memory_order_relaxed);
+			// event written_since may be half written already, it overwrites written_since - EVENTS_PER_THREAD
+			uint64_t intact = begin;
+			if (written_since >= EVENTS_PER_THREAD)
+				intact = std::max(begin, written_since - EVENTS_PER_THREAD + 1);
+			for (uint64_t i = intact; i < end; ++i) {
+				Event const &event = events[i - begin];
+				file << (first ? "\n" : ",\n") << R"({"name":)";
+				write_string(file, event.name);
+				// microseconds, with nanosecond precision
+				file << R"(,"ph":"X","pid":1,"tid":)" << buffer->thread_id
+				     << R"(,"ts":)" << event.begin_nanoseconds / 1000 << '.'
+				     << std::setfill('0') << std::setw(3) << event.begin_nanoseconds % 1000
+				     << R"(,"dur":)" << (event.end_nanoseconds - event.begin_nanoseconds) / 1000 << '.'
+				     << std::setw(3) << (event.end_nanoseconds - event.begin_nanoseconds) % 1000 << '}';
+				first = false;
+			}
+		}
+		file << "\n]}\n";
+		std::cout << "wrote trace to " << file_name << std::endl;
+	}
+
+	void dump_on_signal(int signal_number, char const *file_name) {
+		signal_file_name = file_name;
+		std::signal(signal_number, handle_signal);
+	}
+
+	void poll() {
+		if (dump_requested.exchange(false, std::memory_order_relaxed))
+			dump(signal_file_name);
+	}
+} // av
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef AUDIO_VISUALIZER_TRACE_HPP
+#define AUDIO_VISUALIZER_TRACE_HPP
+
+// scoped trace events, dumped in the chrome trace event format (open with chrome://tracing or ui.perfetto.dev)
+// configure with -DAV_TRACE=ON to enable, otherwise all of this compiles to nothing
+//
+// every thread appends to its own ring buffer, so recording an event is two clock reads and a few stores
+// the first event on a thread registers its buffer, which takes a lock once
+// realtime threads should reserve a Thread up front instead, so they never lock or allocate
+
+#ifdef AV_TRACE
+
+#include <atomic>
+#include <cstdint>
+
+namespace av::trace {
+	class Scope {
+	public:
+		explicit Scope(char const *name) noexcept;
+		~Scope();
+		Scope(Scope const &) = delete;
+		Scope &operator=(Scope const &) = delete;
+	private:
+		char const *name;
+		int64_t begin_nanoseconds;
+	};
+
+	// name shows up in the trace viewer instead of the thread id
+	// registers the calling thread's buffer if it has none yet, so it can allocate
+	void name_thread(char const *name);
+
+	// a named buffer registered ahead of time, from any thread
+	// bind() hands it to the calling thread without locking or allocating
+	// threads that take turns (like successive capture threads) can share one
+	class Thread {
+	public:
+		explicit Thread(char const *name);
+		void bind() const noexcept;
+	private:
+		void *buffer;
+	};
+
+	// write every buffered event to file_name
+	void dump(char const *file_name);
+
+	// dump whenever the process receives signal_number (e.g. SIGUSR1)
+	// the signal handler only sets a flag, the dump itself happens in poll()
+	void dump_on_signal(int signal_number, char const *file_name);
+	void poll();
+} // av
+
+#define AV_TRACE_CONCAT_IMPL(a, b) a##b
+#define AV_TRACE_CONCAT(a, b) AV_TRACE_CONCAT_IMPL(a, b)
+#define AV_TRACE_SCOPE(name) ::av::trace::Scope const AV_TRACE_CONCAT(av_trace_scope_, __LINE__){name}
+#define AV_TRACE_THREAD(name) ::av::trace::name_thread(name)
+#define AV_TRACE_DUMP(file_name) ::av::trace::dump(file_name)
+#define AV_TRACE_DUMP_ON_SIGNAL(signal_number, file_name) ::av::trace::dump_on_signal(signal_number, file_name)
+#define AV_TRACE_POLL() ::av::trace::poll()
+
+#else
+
+namespace av::trace {
+	class Thread {
+	public:
+		explicit Thread(char const *) noexcept {}
+		void bind() const noexcept {}
+	};
+} // av
+
+#define AV_TRACE_SCOPE(name) static_cast<void>(0)
+#define AV_TRACE_THREAD(name) static_cast<void>(0)
+#define AV_TRACE_DUMP(file_name) static_cast<void>(0)
+#define AV_TRACE_DUMP_ON_SIGNAL(signal_number, file_name) static_cast<void>(0)
+#define AV_TRACE_POLL() static_cast<void>(0)
+
+#endif
+
+#endif //AUDIO_VISUALIZER_TRACE_HPP
@@ -0,0 +1,294 @@
+#include "UploadBuffer.hpp"
+
+#include "constants.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace av {
+	namespace {
+		constexpr size_t NUM_BENCHMARK_WARMUPS = 4;
+		constexpr size_t NUM_BENCHMARK_ITERATIONS = 32;
+		// a later strategy has to beat an earlier one by this much, so noise doesn't pick the staging copy
+		constexpr double BENCHMARK_MARGIN = 0.9;
+
+		// both queues touch the buffers when there is a transfer queue, this avoids ownership transfers
+		struct Sharing {
+			std::array<uint32_t, 2> queue_family_indices;
+			bool concurrent;
+
+			Sharing(Gpu const &gpu, UploadStrategy strategy)
+				: queue_family_indices{gpu.queue_family_indices.graphics,
+				                       gpu.queue_family_indices.transfer.value_or(gpu.queue_family_indices.graphics)}
+				, concurrent{strategy == UploadStrategy::staging && gpu.queue_family_indices.transfer.has_value()} {}
+
+			void apply(vk::BufferCreateInfo &buffer_create_info) const {
+				if (!concurrent) return;
+				buffer_create_info.sharingMode = vk::SharingMode::eConcurrent;
+				buffer_create_info.queueFamilyIndexCount = queue_family_indices.size();
+				buffer_create_info.pQueueFamilyIndices = queue_family_indices.data();
+			}
+		};
+	}
+
+	char const *to_string(UploadStrategy strategy) {
+		switch (strategy) {
+			case UploadStrategy::device_local:
+				return "device local";
+			case UploadStrategy::host:
+				return "host";
+			case UploadStrategy::staging:
+				return "staging";
+			default:
+				return "automatic";
+		}
+	}
+
+	UploadBuffer::UploadBuffer(
+		Gpu const &gpu,
+		vma::Allocator const &allocator,
+		vk::DeviceSize size,
+		vk::BufferUsageFlags usage,
+		vk::DeviceSize dynamic_offset,
+		vk::DeviceSize dynamic_size,
+		UploadStrategy strategy
+	) : UploadBuffer{
+		gpu, allocator, size, dynamic_offset, dynamic_size, strategy,
+		create_buffer(gpu, allocator, size, usage, strategy),
+		create_staging_buffer(gpu, allocator, size, strategy)
+	} {}
+
+	UploadBuffer::~UploadBuffer() {
+		_allocator.freeMemory(_staging_allocation); // no-op if null
+		_allocator.freeMemory(_allocation);
+	}
+
+	void UploadBuffer::record_upload(vk::raii::CommandBuffer const &command_buffer, uint32_t flight_frame) const {
+		auto [offset, size] = next_upload_range();
+		if (strategy != UploadStrategy::staging) {
+			_allocator.flushAllocation(_allocation, offset, size); // no-op if the memory is coherent
+			return;
+		}
+		if (!size) return;
+		// earlier frames may still be drawing from the device buffer, no memory dependency needed for a write after read
+		// texel buffers (DashboardBuffer) are read in the vertex shader
+		vk::PipelineStageFlags const read_stages =
+			vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eDrawIndirect
+			| vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eTransfer;
+		command_buffer.pipelineBarrier(read_stages, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, nullptr);
+		record_copy(command_buffer, flight_frame, offset, size);
+		vk::BufferMemoryBarrier after_copy{
+			.srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+			.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead
+			                 | vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead
+			                 | vk::AccessFlagBits::eTransferRead,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = *_buffer,
+			.offset = offset,
+			.size = size,
+		};
+		command_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer, read_stages, {}, nullptr, after_copy, nullptr);
+	}
+
+	void UploadBuffer::record_transfer(vk::raii::CommandBuffer const &command_buffer, uint32_t flight_frame) const {
+		auto [offset, size] = next_upload_range();
+		if (size) record_copy(command_buffer, flight_frame, offset, size);
+	}
+
+	UploadBuffer::UploadBuffer(
+		Gpu const &gpu,
+		vma::Allocator const &allocator,
+		vk::DeviceSize size,
+		vk::DeviceSize dynamic_offset,
+		vk::DeviceSize dynamic_size,
+		UploadStrategy strategy,
+		std::tuple<vk::Buffer, vma::Allocation, void *> const &buffer_objects,
+		std::tuple<vk::Buffer, vma::Allocation, void *> const &staging_objects
+	)
+		: strategy{strategy}
+		, device_local{static_cast<bool>(
+			allocator.getAllocationMemoryProperties(std::get<vma::Allocation>(buffer_objects))
+			& vk::MemoryPropertyFlagBits::eDeviceLocal)}
+		, _allocator{allocator}
+		, _size{size}
+		, _dynamic_offset{dynamic_offset}
+		, _dynamic_size{dynamic_size}
+		, _buffer{gpu.device, std::get<vk::Buffer>(buffer_objects)}
+		, _allocation{std::get<vma::Allocation>(buffer_objects)}
+		, _staging_buffer{std::get<vk::Buffer>(staging_objects)
+		                  ? vk::raii::Buffer{gpu.device, std::get<vk::Buffer>(staging_objects)}
+		                  : vk::raii::Buffer{nullptr}}
+		, _staging_allocation{std::get<vma::Allocation>(staging_objects)}
+		, _staging_data{static_cast<std::byte *>(std::get<void *>(staging_objects))}
+		, _shadow(strategy == UploadStrategy::staging ? size : 0)
+		, _data{strategy == UploadStrategy::staging
+		        ? std::span<std::byte>{_shadow}
+		        : std::span<std::byte>{static_cast<std::byte *>(std::get<void *>(buffer_objects)), size}} {}
+
+	std::tuple<vk::Buffer, vma::Allocation, void *> UploadBuffer::create_buffer(
+		Gpu const &gpu,
+		vma::Allocator const &allocator,
+		vk::DeviceSize size,
+		vk::BufferUsageFlags usage,
+		UploadStrategy strategy
+	) {
+		vk::BufferCreateInfo buffer_create_info{
+			.size = size,
+			.usage = usage,
+			.sharingMode = vk::SharingMode::eExclusive,
+		};
+		Sharing const sharing{gpu, strategy};
+		sharing.apply(buffer_create_info);
+		vma::AllocationCreateInfo allocation_create_info;
+		switch (strategy) {
+			case UploadStrategy::device_local:
+				// base address register memory seemed to cause mouse lag, so benchmark it instead of assuming
+				allocation_create_info = {
+					.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite
+					         | vma::AllocationCreateFlagBits::eMapped,
+					.usage = vma::MemoryUsage::eAutoPreferDevice,
+				};
+				break;
+			case UploadStrategy::host:
+				allocation_create_info = {
+					.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite
+					         | vma::AllocationCreateFlagBits::eMapped,
+					.usage = vma::MemoryUsage::eAutoPreferHost,
+				};
+				break;
+			case UploadStrategy::staging:
+				buffer_create_info.usage |= vk::BufferUsageFlagBits::eTransferDst;
+				allocation_create_info = {.usage = vma::MemoryUsage::eAutoPreferDevice};
+				break;
+			default:
+				throw std::invalid_argument("pick an upload strategy (or benchmark them) before creating a buffer");
+		}
+		vma::AllocationInfo allocation_info;
+		auto buffer_and_allocation = allocator.createBuffer(
+			buffer_create_info, allocation_create_info, &allocation_info);
+		return std::make_tuple(buffer_and_allocation.first, buffer_and_allocation.second, allocation_info.pMappedData);
+	}
+
+	std::tuple<vk::Buffer, vma::Allocation, void *> UploadBuffer::create_staging_buffer(
+		Gpu const &gpu,
+		vma::Allocator const &allocator,
+		vk::DeviceSize size,
+		UploadStrategy strategy
+	) {
+		if (strategy != UploadStrategy::staging) return {nullptr, nullptr, nullptr};
+		vk::BufferCreateInfo buffer_create_info{
+			.size = constants::MAX_FRAMES_IN_FLIGHT * size,
+			.usage = vk::BufferUsageFlagBits::eTransferSrc,
+			.sharingMode = vk::SharingMode::eExclusive,
+		};
+		Sharing const sharing{gpu, strategy};
+		sharing.apply(buffer_create_info);
+		vma::AllocationCreateInfo allocation_create_info{
+			.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
+			.usage = vma::MemoryUsage::eAutoPreferHost,
+		};
+		vma::AllocationInfo allocation_info;
+		auto buffer_and_allocation = allocator.createBuffer(
+			buffer_create_info, allocation_create_info, &allocation_info);
+		return std::make_tuple(buffer_and_allocation.first, buffer_and_allocation.second, allocation_info.pMappedData);
+	}
+
+	std::pair<vk::DeviceSize, vk::DeviceSize> UploadBuffer::next_upload_range() const {
+		if (_uploaded) return {_dynamic_offset, _dynamic_size};
+		_uploaded = true;
+		return {0, _size};
+	}
+
+	void UploadBuffer::record_copy(
+		vk::raii::CommandBuffer const &command_buffer,
+		uint32_t flight_frame,
+		vk::DeviceSize offset,
+		vk::DeviceSize size
+	) const {
+		// the timeline value of this flight frame has signaled, so nothing is reading this slot anymore
+		vk::DeviceSize const staging_offset = flight_frame * _size + offset;
+		std::copy_n(_shadow.begin() + static_cast<std::ptrdiff_t>(offset), size, _staging_data + staging_offset);
+		_allocator.flushAllocation(_staging_allocation, staging_offset, size);
+		command_buffer.copyBuffer(*_staging_buffer, *_buffer, vk::BufferCopy{
+			.srcOffset = staging_offset,
+			.dstOffset = offset,
+			.size = size,
+		});
+	}
+
+	// copying the buffer into device local memory stands in for the vertex stage reading it,
+	// the staging copy runs on the graphics queue here, a transfer queue only adds overlap on top
+	UploadStrategy UploadBuffer::benchmark(Gpu const &gpu, vma::Allocator const &allocator, vk::DeviceSize size, bool print) {
+		vk::BufferCreateInfo scratch_create_info{
+			.size = size,
+			.usage = vk::BufferUsageFlagBits::eTransferDst,
+			.sharingMode = vk::SharingMode::eExclusive,
+		};
+		auto [scratch_buffer, scratch_allocation] = allocator.createBuffer(
+			scratch_create_info, {.usage = vma::MemoryUsage::eAutoPreferDevice});
+		vk::raii::Buffer const scratch{gpu.device, scratch_buffer};
+		vk::raii::CommandBuffer const command_buffer{std::move(vk::raii::CommandBuffers{gpu.device, {
+			.commandPool = *gpu.graphics_command_pool,
+			.level = vk::CommandBufferLevel::ePrimary,
+			.commandBufferCount = 1,
+		}}.front())};
+		std::vector<std::byte> source(size);
+		for (size_t i = 0; i < source.size(); ++i) source[i] = static_cast<std::byte>(i * 2654435761u >> 24);
+
+		if (print)
+			std::cout << "upload strategies, " << size << " bytes per frame\n"
+			          << std::setw(16) << "strategy" << std::setw(16) << "median" << '\n';
+		UploadStrategy best_strategy = UploadStrategy::host;
+		double best_microseconds = std::numeric_limits<double>::infinity();
+		for (UploadStrategy strategy : {UploadStrategy::host, UploadStrategy::device_local, UploadStrategy::staging}) {
+			UploadBuffer upload_buffer{
+				gpu, allocator, size, vk::BufferUsageFlagBits::eTransferSrc, 0, size, strategy};
+			if (strategy == UploadStrategy::device_local && !upload_buffer.device_local) {
+				if (print) std::cout << std::setw(16) << to_string(strategy) << std::setw(16) << "unavailable" << '\n';
+				continue;
+			}
+			std::vector<double> microseconds;
+			for (size_t iteration = 0; iteration < NUM_BENCHMARK_WARMUPS + NUM_BENCHMARK_ITERATIONS; ++iteration) {
+				auto start = std::chrono::steady_clock::now();
+				std::ranges::copy(source, upload_buffer.data.begin()); // the cpu write
+				command_buffer.reset({});
+				command_buffer.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+				upload_buffer.record_upload(command_buffer, 0);
+				command_buffer.copyBuffer(*upload_buffer.buffer, *scratch, vk::BufferCopy{
+					.srcOffset = 0,
+					.dstOffset = 0,
+					.size = size,
+				});
+				command_buffer.end();
+				gpu.graphics_queue.submit(vk::SubmitInfo{
+					.commandBufferCount = 1,
+					.pCommandBuffers = &*command_buffer,
+				});
+				gpu.graphics_queue.waitIdle();
+				if (iteration >= NUM_BENCHMARK_WARMUPS)
+					microseconds.push_back(std::chrono::duration<double, std::micro>(
+						std::chrono::steady_clock::now() - start).count());
+			}
+			std::ranges::nth_element(microseconds, microseconds.begin() + microseconds.size() / 2);
+			double median_microseconds = microseconds[microseconds.size() / 2];
+			if (print)
+				std::cout << std::setw(16) << to_string(strategy) << std::setw(13) << median_microseconds << " us\n";
+			if (median_microseconds < best_microseconds * BENCHMARK_MARGIN) {
+				best_strategy = strategy;
+				best_microseconds = median_microseconds;
+			}
+		}
+		allocator.freeMemory(scratch_allocation);
+		if (print) std::cout << "using " << to_string(best_strategy) << std::endl;
+		return best_strategy;
+	}
+} // av
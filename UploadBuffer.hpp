@@ -0,0 +1,99 @@
+#ifndef AUDIO_VISUALIZER_UPLOADBUFFER_HPP
+#define AUDIO_VISUALIZER_UPLOADBUFFER_HPP
+
+#include "Gpu.hpp"
+#include "graphics_headers.hpp"
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace av {
+	// where the per-frame data goes between the cpu writing it and the gpu drawing from it
+	// which one is fastest depends on the machine, integrated gpus share memory with the cpu
+	// while discrete ones pay for every byte that crosses the bus
+	enum class UploadStrategy {
+		automatic, // benchmark the others at startup, see UploadBuffer::benchmark
+		device_local, // write straight into host visible device local memory (resizable bar, or any memory on integrated gpus)
+		host, // write into host memory, the gpu reads it over the bus every time it draws
+		staging, // write into host memory, copied into device local memory once per frame on the transfer queue if there is one
+	};
+
+	char const *to_string(UploadStrategy);
+
+	// a buffer the cpu writes through data and the gpu reads through buffer
+	// only the dynamic range is uploaded every frame, everything else only once
+	class UploadBuffer {
+	public:
+		UploadBuffer(
+			Gpu const &,
+			vma::Allocator const &,
+			vk::DeviceSize size,
+			vk::BufferUsageFlags,
+			vk::DeviceSize dynamic_offset,
+			vk::DeviceSize dynamic_size,
+			UploadStrategy
+		);
+		~UploadBuffer();
+		// device_local and host flush the mapped memory, staging also records the copy with barriers on both sides
+		// must be recorded outside of the render pass
+		void record_upload(vk::raii::CommandBuffer const &, uint32_t flight_frame) const;
+		// staging only, just the copy, for a transfer queue that synchronizes with the graphics queue through semaphores
+		void record_transfer(vk::raii::CommandBuffer const &, uint32_t flight_frame) const;
+		// times a cpu write plus a gpu read of size bytes with each strategy and returns the fastest
+		static UploadStrategy benchmark(Gpu const &, vma::Allocator const &, vk::DeviceSize size, bool print);
+		std::span<std::byte> const &data{_data};
+		vk::raii::Buffer const &buffer{_buffer};
+		UploadStrategy const strategy;
+		// false if device_local had to fall back to memory the gpu reads over the bus
+		bool const device_local;
+
+	private:
+		vma::Allocator const &_allocator;
+		vk::DeviceSize const _size;
+		vk::DeviceSize const _dynamic_offset;
+		vk::DeviceSize const _dynamic_size;
+		vk::raii::Buffer const _buffer;
+		vma::Allocation const _allocation;
+		vk::raii::Buffer const _staging_buffer; // staging only, a copy of the whole buffer per frame in flight
+		vma::Allocation const _staging_allocation;
+		std::byte *const _staging_data;
+		std::vector<std::byte> _shadow; // staging only, what data points to
+		std::span<std::byte> const _data;
+		mutable bool _uploaded = false; // whether the static ranges have been copied yet
+		UploadBuffer(
+			Gpu const &,
+			vma::Allocator const &,
+			vk::DeviceSize size,
+			vk::DeviceSize dynamic_offset,
+			vk::DeviceSize dynamic_size,
+			UploadStrategy,
+			std::tuple<vk::Buffer, vma::Allocation, void *> const &buffer_objects,
+			std::tuple<vk::Buffer, vma::Allocation, void *> const &staging_objects
+		);
+		static std::tuple<vk::Buffer, vma::Allocation, void *> create_buffer(
+			Gpu const &,
+			vma::Allocator const &,
+			vk::DeviceSize size,
+			vk::BufferUsageFlags,
+			UploadStrategy
+		);
+		static std::tuple<vk::Buffer, vma::Allocation, void *> create_staging_buffer(
+			Gpu const &,
+			vma::Allocator const &,
+			vk::DeviceSize size,
+			UploadStrategy
+		);
+		// offset and size to upload this frame, the whole buffer the first time
+		std::pair<vk::DeviceSize, vk::DeviceSize> next_upload_range() const;
+		void record_copy(
+			vk::raii::CommandBuffer const &,
+			uint32_t flight_frame,
+			vk::DeviceSize offset,
+			vk::DeviceSize size
+		) const;
+	};
+} // av
+
+#endif //AUDIO_VISUALIZER_UPLOADBUFFER_HPP
@@ -12,10 +12,10 @@ namespace av {
 		struct Color {
 			float r, g, b;
 		} color;
-		float color_multiplier;
+		// the magnitude that scales the color comes from a separate, packed stream (see MagnitudeEncoding.hpp)
 
 		static vk::VertexInputBindingDescription const binding_description;
-		static std::array<vk::VertexInputAttributeDescription, 3> const attribute_descriptions;
+		static std::array<vk::VertexInputAttributeDescription, 2> const attribute_descriptions;
 	};
 
 	constexpr vk::VertexInputBindingDescription Vertex::binding_description{
@@ -24,7 +24,7 @@ namespace av {
 		.inputRate = vk::VertexInputRate::eVertex,
 	};
 
-	constexpr std::array<vk::VertexInputAttributeDescription, 3> Vertex::attribute_descriptions{
+	constexpr std::array<vk::VertexInputAttributeDescription, 2> Vertex::attribute_descriptions{
 		vk::VertexInputAttributeDescription{
 			.location = 0,
 			.binding = 0,
@@ -37,12 +37,6 @@ namespace av {
 			.format = vk::Format::eR32G32B32Sfloat,
 			.offset = offsetof(Vertex, color),
 		},
-		vk::VertexInputAttributeDescription{
-			.location = 2,
-			.binding = 0,
-			.format = vk::Format::eR32Sfloat,
-			.offset = offsetof(Vertex, color_multiplier),
-		},
 	};
 } // av
 
@@ -2,72 +2,141 @@
 
 #include "constants.hpp"
 #include <algorithm>
-#include <tuple>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 namespace av {
-	VertexBuffer::VertexBuffer(
-		size_t num_vertices,
-		size_t num_indices,
-		Gpu const &gpu,
-		vma::Allocator const &allocator
-	) : VertexBuffer{
-		num_vertices, num_indices,
-		gpu, allocator,
-		create_mapped_buffer(num_vertices, num_indices, allocator)
-	} {}
+	template<typename Index>
+	std::array<vk::PushConstantRange, 1> const VertexBuffer<Index>::push_constant_ranges{
+		vk::PushConstantRange{
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.offset = 0,
+			.size = sizeof(PushConstants),
+		},
+	};
+
+	template<typename Index>
+	void VertexBuffer<Index>::bind_and_draw(
+		vk::raii::CommandBuffer const &command_buffer,
+		vk::raii::PipelineLayout const &pipeline_layout
+	) const {
+		vk::Buffer const buffer = *_upload_buffer.buffer;
+		vk::DeviceSize const newest_offset = _magnitudes_offset + _streams.newest() * _stream_size;
+		vk::DeviceSize const previous_offset = _magnitudes_offset + _streams.previous() * _stream_size;
+		command_buffer.bindVertexBuffers(0, {buffer, buffer, buffer}, {0, newest_offset, previous_offset});
+		command_buffer.bindIndexBuffer(buffer, _indices_offset, vk::IndexTypeValue<Index>::value);
+		command_buffer.pushConstants<PushConstants>(
+			*pipeline_layout, vk::ShaderStageFlagBits::eVertex, 0, _push_constants);
+		command_buffer.drawIndexed(_num_indices, 1, 0, 0, 0);
+	}
 
+	template<typename Index>
+	void VertexBuffer<Index>::commit_magnitudes() {
+		_streams.commit();
+		_magnitude_data = _upload_buffer.data.subspan(_magnitudes_offset + _streams.write() * _stream_size, _stream_size);
+	}
 
-	VertexBuffer::~VertexBuffer() {
-		_allocator.freeMemory(_allocation);
+	template<typename Index>
+	void VertexBuffer<Index>::mark_drawn(uint64_t frame_value) {
+		_streams.mark_drawn(frame_value);
 	}
 
-	void VertexBuffer::bind_and_draw(const vk::raii::CommandBuffer &command_buffer) const {
-		command_buffer.bindVertexBuffers(0, {*_buffer}, {0});
-		command_buffer.bindIndexBuffer(*_buffer, _num_vertices * sizeof(Vertex), constants::vk_index_type);
-		command_buffer.drawIndexed(_num_indices, 1, 0, 0, 0);
+	template<typename Index>
+	uint64_t VertexBuffer<Index>::write_frame_value() const {
+		return _streams.write_frame_value();
 	}
 
-	VertexBuffer::VertexBuffer(
-		size_t num_vertices,
-		size_t num_indices,
+	template<typename Index>
+	void VertexBuffer<Index>::set_blend(float blend) {
+		_push_constants.blend = blend;
+	}
+
+	template<typename Index>
+	VertexBuffer<Index>::VertexBuffer(
+		MeshLayout const &layout,
 		Gpu const &gpu,
 		vma::Allocator const &allocator,
-		std::tuple<vk::Buffer, vma::Allocation, void *> const &buffer_objects
+		UploadStrategy upload_strategy
 	)
-		: _num_vertices{num_vertices}
-		, _num_indices{num_indices}
-		, _allocator{allocator}
-		, _buffer{gpu.device, std::get<vk::Buffer>(buffer_objects)}
-		, _allocation{std::get<vma::Allocation>(buffer_objects)}
-		, _vertex_data{static_cast<Vertex *const>(std::get<void *>(buffer_objects)), num_vertices}
+		: magnitude_format{layout.magnitude_format}
+		, _num_vertices{layout.num_vertices}
+		, _num_indices{layout.num_indices}
+		, _magnitudes_offset{layout.num_vertices * sizeof(Vertex)}
+		, _stream_size{layout.num_vertices * magnitude_size(layout.magnitude_format)}
+		, _indices_offset{get_indices_offset(layout)}
+		, _binding_descriptions{
+			Vertex::binding_description,
+			vk::VertexInputBindingDescription{
+				.binding = 1,
+				.stride = static_cast<uint32_t>(magnitude_size(layout.magnitude_format)),
+				.inputRate = vk::VertexInputRate::eVertex,
+			},
+			vk::VertexInputBindingDescription{
+				.binding = 2,
+				.stride = static_cast<uint32_t>(magnitude_size(layout.magnitude_format)),
+				.inputRate = vk::VertexInputRate::eVertex,
+			},
+		}
+		, _attribute_descriptions{
+			Vertex::attribute_descriptions[0],
+			Vertex::attribute_descriptions[1],
+			vk::VertexInputAttributeDescription{
+				.location = 2,
+				.binding = 1,
+				.format = magnitude_vk_format(layout.magnitude_format),
+				.offset = 0,
+			},
+			vk::VertexInputAttributeDescription{
+				.location = 3,
+				.binding = 2,
+				.format = magnitude_vk_format(layout.magnitude_format),
+				.offset = 0,
+			},
+		}
+		, _pipeline_description{
+			.vertex_shader_file_name = constants::VERTEX_SHADER_FILE_NAME,
+			.fragment_shader_file_name = constants::FRAGMENT_SHADER_FILE_NAME,
+			.binding_descriptions = _binding_descriptions,
+			.attribute_descriptions = _attribute_descriptions,
+			.topology = vk::PrimitiveTopology::eTriangleStrip,
+			.push_constant_ranges = push_constant_ranges,
+		}
+		, _upload_buffer{
+			gpu, allocator, get_buffer_size(layout),
+			vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer,
+			_magnitudes_offset, MagnitudeSlots::NUM_SLOTS * _stream_size,
+			upload_strategy
+		}
+		, _vertex_data{reinterpret_cast<Vertex *const>(_upload_buffer.data.data()), layout.num_vertices}
+		, _magnitude_data{_upload_buffer.data.subspan(_magnitudes_offset, _stream_size)}
 		, _index_data{
-			reinterpret_cast<constants::index_t *const>(
-				reinterpret_cast<Vertex *>(std::get<void *>(buffer_objects))
-				+ num_vertices
-			),
-			num_indices
-		} {}
+			reinterpret_cast<Index *const>(_upload_buffer.data.data() + _indices_offset),
+			layout.num_indices
+		} {
+		// encodes 0 in every format
+		std::ranges::fill(
+			_upload_buffer.data.subspan(_magnitudes_offset, MagnitudeSlots::NUM_SLOTS * _stream_size), std::byte{0});
+	}
 
-	std::tuple<vk::Buffer, vma::Allocation, void *> VertexBuffer::create_mapped_buffer(
-		size_t num_vertices,
-		size_t num_indices,
-		vma::Allocator const &allocator
-	) {
-		// todo check for alignment issues
-		vk::BufferCreateInfo buffer_create_info{
-			.size = num_vertices * sizeof(Vertex) + num_indices * sizeof(constants::index_t),
-			.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer,
-			.sharingMode = vk::SharingMode::eExclusive,
-		};
-		vma::AllocationCreateInfo allocation_create_info{
-			.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
-			.usage = vma::MemoryUsage::eAutoPreferHost, // base address register memory causes mouse lag?
-		};
-		vma::AllocationInfo allocation_info;
-		auto buffer_and_allocation = allocator.createBuffer(
-			buffer_create_info, allocation_create_info, &allocation_info);
-//		std::string vertex_buffer_memory_type = to_string(vk::MemoryPropertyFlags(allocation_info.memoryType));
-		return std::make_tuple(buffer_and_allocation.first, buffer_and_allocation.second, allocation_info.pMappedData);
+	// the magnitudes may be single bytes, so round up to keep the indices aligned for both index types
+	template<typename Index>
+	vk::DeviceSize VertexBuffer<Index>::get_indices_offset(MeshLayout const &layout) {
+		// sizeof(Vertex) is a multiple of 4, so the magnitudes are aligned for every format
+		static_assert(sizeof(Vertex) % sizeof(uint32_t) == 0);
+		vk::DeviceSize end_of_magnitudes = layout.num_vertices * sizeof(Vertex)
+			+ MagnitudeSlots::NUM_SLOTS * layout.num_vertices * magnitude_size(layout.magnitude_format);
+		return (end_of_magnitudes + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t);
 	}
+
+	template<typename Index>
+	vk::DeviceSize VertexBuffer<Index>::get_buffer_size(MeshLayout const &layout) {
+		if (layout.num_vertices > MAX_VERTICES)
+			throw std::length_error("too many vertices for the index type");
+		return get_indices_offset(layout) + layout.num_indices * sizeof(Index);
+	}
+
+	template class VertexBuffer<uint16_t>;
+	template class VertexBuffer<uint32_t>;
 } // av
@@ -3,47 +3,82 @@
 
 #include "constants.hpp"
 #include "Gpu.hpp"
+#include "Layout.hpp"
+#include "MagnitudeEncoding.hpp"
+#include "MagnitudeSlots.hpp"
+#include "PipelineDescription.hpp"
+#include "UploadBuffer.hpp"
 #include "Vertex.hpp"
 #include "graphics_headers.hpp"
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <span>
-#include <tuple>
 #include <vector>
 
 namespace av {
+	// Index is uint16_t or uint32_t, see the explicit instantiations at the bottom
+	// prefer uint16_t whenever the mesh fits, it halves the index bandwidth
+	// the per-vertex magnitudes live in their own packed streams between the vertices and the indices,
+	// so a frame only rewrites num_vertices * magnitude_size(format) bytes
+	// the newest analysis frame and the one before it are blended in the shader,
+	// and there are a few more streams so the one being written isn't read by a frame in flight, see MagnitudeSlots
+	template<typename Index>
 	class VertexBuffer {
 	public:
 		VertexBuffer(
-			size_t num_vertices,
-			size_t num_indices,
+			MeshLayout const &,
 			Gpu const &,
-			vma::Allocator const &
+			vma::Allocator const &,
+			UploadStrategy
 		);
-		~VertexBuffer();
-		void bind_and_draw(vk::raii::CommandBuffer const &) const;
+		void bind_and_draw(vk::raii::CommandBuffer const &, vk::raii::PipelineLayout const &) const;
+		// after writing a frame into magnitude_data, it becomes the newest and magnitude_data moves to the next stream
+		// wait for write_frame_value on the FrameTimeline before writing into it
+		void commit_magnitudes();
+		// frame_value is signaled once the frame just recorded is done reading the streams
+		void mark_drawn(uint64_t frame_value);
+		[[nodiscard]] uint64_t write_frame_value() const;
+		// 0 draws the previous frame, 1 the newest
+		void set_blend(float);
 		std::span<Vertex> const &vertex_data{_vertex_data};
-		std::span<constants::index_t> const &index_data{_index_data};
+		std::span<Index> const &index_data{_index_data};
+		// one encoded magnitude per vertex, see encode_magnitudes, only valid until the next commit_magnitudes
+		std::span<std::byte> const &magnitude_data{_magnitude_data};
+		// only the magnitudes are uploaded every frame
+		UploadBuffer const &upload_buffer{_upload_buffer};
+		MagnitudeFormat const magnitude_format;
+		PipelineDescription const &pipeline_description{_pipeline_description};
+		// every vertex has to be addressable by an index
+		static constexpr size_t MAX_VERTICES = size_t{std::numeric_limits<Index>::max()} + 1;
+
+		struct PushConstants {
+			float blend; // where the display time falls between the two frames
+		};
 
 	private:
 		size_t _num_vertices;
 		size_t _num_indices;
-		vma::Allocator const &_allocator;
-		vk::raii::Buffer const _buffer;
-		vma::Allocation const _allocation;
+		vk::DeviceSize _magnitudes_offset;
+		vk::DeviceSize _stream_size; // one frame of encoded magnitudes
+		vk::DeviceSize _indices_offset;
+		PushConstants _push_constants{.blend = 1.0f};
+		std::array<vk::VertexInputBindingDescription, 3> const _binding_descriptions;
+		std::array<vk::VertexInputAttributeDescription, 4> const _attribute_descriptions;
+		PipelineDescription const _pipeline_description; // after everything it points into
+		UploadBuffer const _upload_buffer;
+		MagnitudeSlots _streams;
 		std::span<Vertex> const _vertex_data;
-		std::span<constants::index_t> const _index_data;
-		VertexBuffer(
-			size_t num_vertices,
-			size_t num_indices,
-			Gpu const &,
-			vma::Allocator const &,
-			std::tuple<vk::Buffer, vma::Allocation, void *> const &
-		);
-		static std::tuple<vk::Buffer, vma::Allocation, void *> create_mapped_buffer(
-			size_t num_vertices,
-			size_t num_indices,
-			vma::Allocator const &
-		);
+		std::span<std::byte> _magnitude_data;
+		std::span<Index> const _index_data;
+		static vk::DeviceSize get_indices_offset(MeshLayout const &);
+		static vk::DeviceSize get_buffer_size(MeshLayout const &);
+
+		static std::array<vk::PushConstantRange, 1> const push_constant_ranges;
 	};
+
+	extern template class VertexBuffer<uint16_t>;
+	extern template class VertexBuffer<uint32_t>;
 } // av
 
 #endif //AUDIO_VISUALIZER_VERTEXBUFFER_HPP
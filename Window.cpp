@@ -3,18 +3,24 @@
 #include "constants.hpp"
 #include <iostream>
 #include <utility>
+#include <vector>
 
 namespace av {
-	Window::Window(bool &framebuffer_resized) :
+	Window::Window(vk::raii::Instance const &instance, size_t index) :
 		vkfw::UniqueWindow{vkfw::createWindowUnique(
 			constants::WIDTH, constants::HEIGHT, constants::TITLE,
 			{.floating = constants::ON_TOP}
-		)} {
+		)},
+		_surface{instance, vkfw::createWindowSurface(*instance, **this)} {
 		vkfw::setErrorCallback([](int error_code, char const *const description) {
 			std::cerr << "glfw error callback: error code " << error_code << ", " << description << std::endl;
 		});
-		(*this)->callbacks()->on_framebuffer_resize = [&](vkfw::Window const &, size_t, size_t) {
+		(*this)->callbacks()->on_framebuffer_resize = [this](vkfw::Window const &, size_t, size_t) {
 			framebuffer_resized = true;
 		};
+		if (index == 0) return;
+		std::vector<vkfw::Monitor> monitors = vkfw::getMonitors();
+		if (index < monitors.size())
+			(*this)->setPos(monitors[index].getWorkareaPos());
 	}
 } // av
@@ -2,11 +2,18 @@
 #define AUDIO_VISUALIZER_WINDOW_HPP
 
 #include "graphics_headers.hpp"
+#include <cstddef>
 
 namespace av {
 	class Window : public vkfw::UniqueWindow {
 	public:
-		explicit Window(bool &framebuffer_resized);
+		// window n > 0 opens on monitor n if there is one, the first is left to the window manager
+		// the resize callback points at this, so windows have to stay where they are constructed
+		Window(vk::raii::Instance const &, size_t index);
+		vk::raii::SurfaceKHR const &surface{_surface};
+		bool framebuffer_resized = false;
+	private:
+		vk::raii::SurfaceKHR _surface;
 	};
 } // av
 
@@ -15,7 +15,8 @@ namespace av::constants {
 	static constexpr char const *TITLE = "av";
 	static constexpr bool ON_TOP{true};
 
-	static constexpr uint32_t VK_API_VERSION = VK_API_VERSION_1_1;
+	// the highest version used, devices without 1.2 get timeline semaphores from VK_KHR_timeline_semaphore
+	static constexpr uint32_t VK_API_VERSION = VK_API_VERSION_1_2;
 //	static constexpr auto GLOBAL_LAYERS = []() {
 //		if constexpr(DEBUG) return std::array{"VK_LAYER_KHRONOS_validation"};
 //		else return std::array<char const *, 0>();
@@ -29,11 +30,19 @@ namespace av::constants {
 	static constexpr char const *APPLICATION_NAME = "audio visualizer";
 	static constexpr char const *VERTEX_SHADER_FILE_NAME = "shaders/shader.vert.spv";
 	static constexpr char const *FRAGMENT_SHADER_FILE_NAME = "shaders/shader.frag.spv";
+	static constexpr char const *BARS_VERTEX_SHADER_FILE_NAME = "shaders/bars.vert.spv";
+	static constexpr char const *PEAKS_VERTEX_SHADER_FILE_NAME = "shaders/peaks.vert.spv";
+	static constexpr char const *SPECTROGRAM_VERTEX_SHADER_FILE_NAME = "shaders/spectrogram.vert.spv";
+	static constexpr char const *SPECTROGRAM_FRAGMENT_SHADER_FILE_NAME = "shaders/spectrogram.frag.spv";
+	static constexpr char const *DASHBOARD_VERTEX_SHADER_FILE_NAME = "shaders/dashboard.vert.spv";
 
+	// upper bound, the LatencyPolicy picks how many are actually used
 	static constexpr size_t MAX_FRAMES_IN_FLIGHT = 3;
-
-	using index_t = uint16_t;
-	static constexpr vk::IndexType vk_index_type = vk::IndexType::eUint16;
+	// bytes written and read per strategy when UploadStrategy::automatic benchmarks them,
+	// enough to rise above the submission overhead
+	static constexpr size_t UPLOAD_BENCHMARK_SIZE = 256 * 1024;
+	// waiting this long for a frame means the gpu is hung
+	static constexpr uint64_t FRAME_TIMEOUT_NANOSECONDS = 1'000'000'000;
 } // av
 
 #endif //AUDIO_VISUALIZER_CONSTANTS_HPP
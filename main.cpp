@@ -1,24 +1,96 @@
 #include "constants.hpp"
+#include "Goertzel.hpp"
+#include "MagnitudeEncoding.hpp"
+#include "NetworkSender.hpp"
+#include "PeakDetector.hpp"
+#include "Realtime.hpp"
 #include "Renderer.hpp"
+#include "SoundAnalyzer.hpp"
+#include "Smoother.hpp"
 #include "SoundRecorder.hpp"
+#include "SpectrumRecorder.hpp"
+#include "SpectrumReplay.hpp"
+#include "SpectrumPublisher.hpp"
+#include "SpscQueue.hpp"
+#include "Trace.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <csignal>
 #include <exception>
+#include <future>
 #include <iostream>
 #include <numeric>
+#include <optional>
 #include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <system_error>
+#include <thread>
+#include <variant>
 #include <vector>
 
 constexpr long double lo_frequency = 55.0l;
 constexpr long double hi_frequency = 4186.009044809578l;
 constexpr unsigned int num_goertzel_samples = 480 * 16;
-constexpr unsigned int num_history_samples = 480000;
+constexpr bool goertzel_report = false; // print the accuracy and speed of the goertzel kernels at startup
+constexpr bool print_tables = false; // print the frequencies, y values and vertices at startup
+constexpr unsigned int num_history_samples = num_goertzel_samples; // nothing reads further back than goertzel
 constexpr unsigned int freqs_per_octave = 12 * 2;
-constexpr float dampening_factor = 0.95f; // higher values mean the max volume (for normalization) will decrease slower
-constexpr unsigned int target_fps = 90;
+// per-bin attack/release and automatic gain control, in real time so it doesn't change with target_fps
+constexpr av::SmoothingOptions smoothing_options{};
+constexpr unsigned int target_fps = 144; // drawing
+// goertzel, smoothing, the analyzer and every consumer, the renderer interpolates the frames in between
+constexpr unsigned int analysis_fps = 90;
+// present mode, swapchain size and frames in flight, see LatencyPolicy.hpp
+constexpr av::LatencyPolicy latency_policy = av::LatencyPolicy::lowest_latency;
+// how magnitudes reach the gpu, automatic benchmarks the options at startup, see UploadBuffer.hpp
+constexpr av::UploadStrategy upload_strategy = av::UploadStrategy::automatic;
+// one window per display, all drawn by one device from the same analysis, window n > 0 opens on monitor n
+constexpr size_t num_windows = 1;
+constexpr unsigned int spectrogram_seconds = 10; // history shown by the SPECTROGRAM layout
+constexpr uint32_t max_peaks = 32; // strongest local maxima kept per frame
+constexpr float peak_threshold = 0.01f; // normalized, quieter maxima are ignored
+constexpr bool peaks_only = false; // the other layouts only light up the peak bins
+constexpr bool detect_beats = false; // print a line per beat, see SoundAnalyzer.hpp
+constexpr uint32_t chroma_classes = 12; // 12 or 24, also the number of bars in the CHROMA layout
+// cells of the DASHBOARD layout, each gets a copy of the one analysis until there is one per input channel
+constexpr uint32_t dashboard_channels = 16;
+constexpr av::SoundAnalyzerOptions sound_analyzer_options{.chroma_classes = chroma_classes};
+// float16 and unorm8 halve or quarter the per-frame upload, see MagnitudeEncoding.hpp
+constexpr av::MagnitudeFormat magnitude_format = av::MagnitudeFormat::float16;
+// see Realtime.hpp -- the priorities need RLIMIT_RTPRIO (or root), and the capture thread should have the higher one
+// careful with the analysis priority, the frame limiter below busy-waits
+constexpr av::CaptureOptions capture_options{
+	.lock_history = true,
+	.huge_pages = false,
+	.capture_thread = {.priority = 0, .cpu = -1},
+	.meter_loudness = false, // prints the ebu r128 loudness once a second, see LoudnessMeter.hpp
+};
+// type a device index or part of a name into the console and press enter to switch to it (see --list-devices)
+constexpr bool switch_devices_from_console = true;
+constexpr av::realtime::ThreadOptions analysis_thread_options{.priority = 0, .cpu = -1};
+constexpr char const *trace_file_name = "trace.json"; // only used when built with AV_TRACE
+// set to a name like "/audio_visualizer_spectrum" to share every frame with other processes (see SpectrumReader.hpp)
+constexpr char const *shared_spectrum_name = nullptr;
+// stream the normalized magnitudes over udp, e.g. std::array{av::NetworkDestination{"127.0.0.1", 9000}}
+constexpr std::array<av::NetworkDestination, 0> network_destinations{};
+constexpr av::NetworkOptions network_options{
+	.encoding = av::NetworkOptions::Encoding::osc,
+	.quantization = av::NetworkOptions::Quantization::log8,
+	.delta = true,
+};
+// record the normalized magnitudes of the whole run (see SpectrumFile.hpp), e.g. "show.avspec"
+// switching to a capture device with another sample rate continues in "show.avspec.1" and so on
+constexpr char const *record_file_name = nullptr;
+constexpr av::SpectrumRecordingOptions recording_options{};
+// replay a recording instead of analyzing the capture device, it has to use the same frequencies
+constexpr char const *replay_file_name = nullptr;
+constexpr double replay_start_seconds = 0.0;
 
 
 // perf doesn't work
@@ -31,10 +103,11 @@ namespace timer {
 	}
 
 	// stop stopwatch and print message
-	void stop() {
+	// gpu_nanoseconds comes from the renderer's timestamp queries, and lags a few frames behind the cpu
+	void stop(uint64_t gpu_nanoseconds) {
 		auto stop_time = std::chrono::steady_clock::now();
 		auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(stop_time - start_time).count();
-		std::cout << 1000000000 / nanos << ' ';
+		std::cout << 1000000000 / nanos << "fps cpu " << nanos / 1000 << "us gpu " << gpu_nanoseconds / 1000 << "us\n";
 	}
 }
 
@@ -86,81 +159,22 @@ std::vector<float> generate_y_values(unsigned int n) {
 // https://tauday.com/tau-manifesto
 constexpr long double tau = std::numbers::pi_v<long double> * 2.0l;
 
-// goertzel algorithm -- see figure 4 here https://asp-eurasipjournals.springeropen.com/articles/10.1186/1687-6180-2012-56
-// i also used euler's formula to avoid complex arithmetic -- exp(j x) = cos(x) + j sin(x)
-// which ended up giving the algorithm described here https://www.embedded.com/the-goertzel-algorithm/
-/* the algorithm i will be using:
- * x = the signal (zero-indexed)
- * N = number of samples in the signal
- * g = 2 cos(tau frequency / sample_rate)
- * s0 = s1 = s2 = 0
- * for i in [0, N-2]
- *   s0 = g * s1 - s2 + x[i]
- *   s2 = s1
- *   s1 = s0
- * s0 = g * s1 - s2 + x[N-1]
- * squared magnitude = s0**2 + s1**2 - s0*s1*g
- * todo how to test this
- */
-std::vector<float> generate_goertzel_constants(std::vector<long double> const &frequencies, long double sample_rate) {
-	std::vector<float> goertzel_constants;
-	goertzel_constants.reserve(frequencies.size());
-	for (long double f : frequencies)
-		goertzel_constants.emplace_back(2.0l * cos(f * tau / sample_rate));
-	return goertzel_constants;
-}
-
-std::vector<float> s0, s1, s2;
 std::vector<float> mag; // squared magnitudes (the outputs of the goertzel algorithm)
-void compute_goertzel(av::SoundRecorder &rec, std::vector<float> const &goertzel_constants) {
-	// todo SSE/AVX ? also check if the compiler does it automatically
-/*
-	for (size_t i = 0; i < num_freqs; ++i) {
-		float const &g = goertzel_constants[i];
-		float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f;
-		for (float *p = rec.sample_history_begin; p != rec.sample_history_end; ++p) {
-			s0 = g * s1 - s2 + *p;
-			s2 = s1;
-			s1 = s0;
-		} // it's fine if the signal isn't in order
-		mag[i] = s1 * s1 + s2 * s2 - s1 * s2 * g;
-	}
-*/
-	std::ranges::fill(s1, 0.0f);
-	std::ranges::fill(s2, 0.0f);
-	float *ptr = rec.sample_history_ptr; // prevent race conditions
-	if (ptr - num_goertzel_samples < rec.sample_history_begin) {
-		for (float *p = rec.sample_history_end - (ptr - rec.sample_history_begin); p != rec.sample_history_end; ++p) {
-			float sample = *p;
-			for (size_t i = 0; i < goertzel_constants.size(); ++i)
-				s0[i] = goertzel_constants[i] * s1[i] - s2[i] + sample;
-			s2 = s1;
-			s1 = s0;
-			for (size_t i = 0; i < goertzel_constants.size(); ++i)
-				mag[i] = s1[i] * s1[i] + s2[i] * s2[i] - s1[i] * s2[i] * goertzel_constants[i];
-		}
-		for (float *p = rec.sample_history_begin; p != ptr; ++p) {
-			float sample = *p;
-			for (size_t i = 0; i < goertzel_constants.size(); ++i)
-				s0[i] = goertzel_constants[i] * s1[i] - s2[i] + sample;
-			s2 = s1;
-			s1 = s0;
-			for (size_t i = 0; i < goertzel_constants.size(); ++i)
-				mag[i] = s1[i] * s1[i] + s2[i] * s2[i] - s1[i] * s2[i] * goertzel_constants[i];
-		}
-	} else {
-		for (float *p = ptr - num_goertzel_samples; p != ptr; ++p) {
-			float sample = *p;
-			for (size_t i = 0; i < goertzel_constants.size(); ++i)
-				s0[i] = goertzel_constants[i] * s1[i] - s2[i] + sample;
-			s2 = s1;
-			s1 = s0;
-			for (size_t i = 0; i < goertzel_constants.size(); ++i)
-				mag[i] = s1[i] * s1[i] + s2[i] * s2[i] - s1[i] * s2[i] * goertzel_constants[i];
-		}
-	}
+void compute_goertzel(av::SoundRecorder &rec, av::Goertzel &goertzel) {
+	float *ptr = rec.sample_history_ptr.load(std::memory_order_acquire); // prevent race conditions
+	auto num_newer_samples = static_cast<size_t>(ptr - rec.sample_history_begin);
+	if (num_newer_samples < num_goertzel_samples) // the window wraps around the end of the ring
+		goertzel.compute(
+			{rec.sample_history_end - (num_goertzel_samples - num_newer_samples), rec.sample_history_end},
+			{rec.sample_history_begin, ptr}, mag);
+	else
+		goertzel.compute({ptr - num_goertzel_samples, ptr}, {}, mag);
 }
 
+// lines typed into the console, for switch_devices_from_console
+// global because the thread reading the console is never joined, it's blocked on std::cin until the process ends
+av::SpscQueue<std::string> device_requests{4, std::string{}};
+
 std::vector<av::Vertex::Color> make_rainbow(size_t n) {
 	std::vector<av::Vertex::Color> rainbow(n);
 	for (size_t i = 0; i < n; ++i) {
@@ -202,45 +216,93 @@ std::vector<av::Vertex::Color> make_rainbow(size_t n) {
 }
 
 constexpr unsigned long long target_nanoseconds_per_rainbow_cycle = 8e9;
-constexpr unsigned int target_nanoseconds_per_frame = 1000000000 / target_fps;
-static_assert(0.0f < dampening_factor && dampening_factor < 1.0f);
+constexpr unsigned int target_nanoseconds_per_frame = 1000000000 / target_fps;
+constexpr std::chrono::nanoseconds analysis_period{1000000000 / analysis_fps};
 
-int main() {
+int main(int argc, char **argv) {
 	try {
-		std::cout << "HIIII" << std::endl;
+		char const *device_name = nullptr; // the system default
+		for (int i = 1; i < argc; ++i) {
+			std::string_view arg = argv[i];
+			if (arg == "--list-devices") {
+				av::SoundRecorder::print_recording_devices();
+				return EXIT_SUCCESS;
+			} else if (arg == "--device" && i + 1 < argc)
+				device_name = argv[++i];
+			else
+				throw std::invalid_argument("usage: " + std::string{argv[0]} + " [--list-devices] [--device index-or-name]");
+		}
+		auto const startup_start = std::chrono::steady_clock::now();
+		auto milliseconds_since = [](std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		};
+		if (print_tables)
+			std::cout << "HIIII\n";
+		AV_TRACE_THREAD("render");
+#ifdef SIGUSR1
+		AV_TRACE_DUMP_ON_SIGNAL(SIGUSR1, trace_file_name);
+#endif
 		// todo adjust these
 		std::vector<long double> frequencies = generate_frequencies(lo_frequency, hi_frequency, freqs_per_octave);
 //		std::ranges::reverse(frequencies);
 		size_t num_freqs = frequencies.size();
 		std::vector<float> y_values = generate_y_values(num_freqs);
-		av::SoundRecorder rec(num_history_samples);
-		std::vector<float> goertzel_constants = generate_goertzel_constants(frequencies, rec.get_sample_rate());
-		{
+		mag.resize(num_freqs);
+
+		// the audio device and the goertzel tables come up on their own thread while this one brings up the window
+		// and vulkan (glfw has to stay on the main thread), nothing below touches them until the future is ready
+		std::optional<av::SpectrumReplay> replay;
+		std::optional<av::SoundRecorder> rec;
+		float sample_rate;
+		std::optional<av::Goertzel> goertzel; // rebuilt when a new capture device has another sample rate
+		std::future<double> audio_startup = std::async(std::launch::async, [&] {
+			AV_TRACE_THREAD("startup");
+			AV_TRACE_SCOPE("audio startup");
+			auto start = std::chrono::steady_clock::now();
+			if (replay_file_name) {
+				replay.emplace(replay_file_name);
+				if (!replay->num_frames())
+					throw std::runtime_error("the recording is empty");
+				// stored as doubles, so only equal up to rounding
+				if (!std::ranges::equal(replay->frequencies(), frequencies, [](double recorded, long double frequency) {
+					return std::abs(static_cast<long double>(recorded) - frequency) <= 1e-9l * frequency;
+				}))
+					throw std::runtime_error("the recording uses different frequencies");
+			} else
+				rec.emplace(num_history_samples, capture_options, device_name);
+			sample_rate = replay ? replay->sample_rate() : rec->get_sample_rate();
+			if (goertzel_report)
+				av::Goertzel::print_report(frequencies, sample_rate, num_goertzel_samples);
+			goertzel.emplace(frequencies, sample_rate);
+			return milliseconds_since(start);
+		});
+		if (print_tables) {
 			std::cout << "frequencies:";
 			for (long double frequency : frequencies)
 				std::cout << ' ' << frequency;
-			std::cout << std::endl << std::endl;
+			std::cout << "\n\n";
 			std::cout << "y values:";
 			for (float y_value : y_values)
 				std::cout << ' ' << y_value;
-			std::cout << std::endl << std::endl;
-			std::cout << "goertzel constants:";
-			for (float goertzel_constant : goertzel_constants)
-				std::cout << ' ' << goertzel_constant;
-			std::cout << std::endl << std::endl;
+			std::cout << "\n\n";
 		}
-		s0.resize(num_freqs);
-		s1.resize(num_freqs);
-		s2.resize(num_freqs);
-		mag.resize(num_freqs);
 
 		using Vertex = av::Vertex;
 
 		std::vector<Vertex> vertex_vector;
-		std::vector<av::constants::index_t> index_vector;
+		std::vector<uint32_t> index_vector; // narrowed to 16 bits by the renderer if the mesh is small enough
 
 #define CIRCLE
-#ifdef CIRCLE
+//#define BARS // one instanced quad per frequency, only the magnitudes are uploaded
+//#define SPECTROGRAM // scrolling history, one column of magnitudes is uploaded per frame
+//#define PEAKS // only the detected peaks are uploaded, drawn as thin lines at their interpolated bins
+//#define CHROMA // one bar per pitch class, from the SoundAnalyzer
+//#define DASHBOARD // a grid of bar spectra, one per channel, all in one draw call
+// none of them: horizontal lines
+#if defined(CIRCLE) + defined(BARS) + defined(SPECTROGRAM) + defined(PEAKS) + defined(CHROMA) + defined(DASHBOARD) > 1
+#error "CIRCLE, BARS, SPECTROGRAM, PEAKS, CHROMA and DASHBOARD are mutually exclusive"
+#endif
+#if defined(CIRCLE)
 		std::vector<Vertex::Color> rainbow = make_rainbow(num_freqs);
 		vertex_vector.reserve(num_freqs);
 		for (size_t i = 1; i <= num_freqs; ++i) {
@@ -251,7 +313,6 @@ int main() {
 //					rainbow[i % freqs_per_octave],
 //					{1.0f, 1.0f, 1.0f,},
 					rainbow[i - 1],
-					0.0f,
 				}
 			);
 		}
@@ -259,98 +320,257 @@ int main() {
 			index_vector.emplace_back(i);
 			index_vector.emplace_back(i + freqs_per_octave);
 		}
+#elif defined(BARS) || defined(SPECTROGRAM) || defined(PEAKS) || defined(CHROMA) || defined(DASHBOARD)
+		std::vector<Vertex::Color> rainbow = make_rainbow(freqs_per_octave); // only for timing, the shaders have their own
 #else
 		std::vector<Vertex::Color> rainbow = make_rainbow(freqs_per_octave);
 		vertex_vector.reserve(num_freqs * 2 + 4);
-		vertex_vector.emplace_back(Vertex{{-1.0f, +1.0f},
-		                                  {},
-		                                  0.0f,});
-		vertex_vector.emplace_back(Vertex{{+1.0f, +1.0f},
-		                                  {},
-		                                  0.0f,});
+		vertex_vector.emplace_back(Vertex{{-1.0f, +1.0f}, {}});
+		vertex_vector.emplace_back(Vertex{{+1.0f, +1.0f}, {}});
 		for (size_t i = 0; i < num_freqs; ++i) {
 			vertex_vector.emplace_back(
 				Vertex{
 					{-1.0f, y_values[i]},
 					rainbow[i % freqs_per_octave],
-					0.0f,
 				}
 			);
 			vertex_vector.emplace_back(
 				Vertex{
 					{+1.0f, y_values[i]},
 					rainbow[i % freqs_per_octave],
-					0.0f,
 				}
 			);
 		}
-		vertex_vector.emplace_back(Vertex{{-1.0f, -1.0f},
-		                                  {},
-		                                  0.0f,});
-		vertex_vector.emplace_back(Vertex{{+1.0f, -1.0f},
-		                                  {},
-		                                  0.0f,});
+		vertex_vector.emplace_back(Vertex{{-1.0f, -1.0f}, {}});
+		vertex_vector.emplace_back(Vertex{{+1.0f, -1.0f}, {}});
 		index_vector.resize(vertex_vector.size());
 		std::iota(index_vector.begin(), index_vector.end(), 0);
 #endif
 
-		for (auto &&v : vertex_vector) {
-			std::cout << v.position.x << ',' << v.position.y << '\n';
-		}
+		if (print_tables)
+			for (auto &&v : vertex_vector) {
+				std::cout << v.position.x << ',' << v.position.y << '\n';
+			}
+		double tables_milliseconds = milliseconds_since(startup_start);
 
 		// a lot of this work can probably be put in the shader todo
 
 //		timer::start();
-		av::Renderer renderer{vertex_vector.size(), index_vector.size()};
-		std::span<Vertex> const &vertex_data = renderer.vertex_data;
-		std::span<av::constants::index_t> const &index_data = renderer.index_data;
-		std::ranges::copy(vertex_vector, vertex_data.begin());
-		std::ranges::copy(index_vector, index_data.begin());
+#ifdef BARS
+		av::Layout const layout = av::BarLayout{static_cast<uint32_t>(num_freqs), freqs_per_octave, magnitude_format};
+#elif defined(SPECTROGRAM)
+		av::Layout const layout = av::SpectrogramLayout{
+			static_cast<uint32_t>(num_freqs), freqs_per_octave, spectrogram_seconds * analysis_fps, magnitude_format};
+#elif defined(PEAKS)
+		av::Layout const layout = av::PeakLayout{max_peaks, static_cast<uint32_t>(num_freqs), freqs_per_octave};
+#elif defined(CHROMA)
+		av::Layout const layout = av::BarLayout{chroma_classes, chroma_classes, magnitude_format};
+#elif defined(DASHBOARD)
+		av::Layout const layout = av::DashboardLayout{
+			dashboard_channels, static_cast<uint32_t>(num_freqs), freqs_per_octave, 0, magnitude_format};
+#else
+		av::Layout const layout = av::MeshLayout{vertex_vector.size(), index_vector.size(), magnitude_format};
+#endif
+		av::Renderer renderer{std::vector<av::Layout>(num_windows, layout), latency_policy, upload_strategy};
+#if !defined(BARS) && !defined(SPECTROGRAM) && !defined(PEAKS) && !defined(CHROMA) && !defined(DASHBOARD)
+		for (av::Output const &output : renderer.outputs)
+			std::visit([&](auto const &geometry) {
+				if constexpr (requires { geometry.index_data; }) {
+					std::ranges::copy(vertex_vector, geometry.vertex_data.begin());
+					std::ranges::copy(index_vector, geometry.index_data.begin());
+				}
+			}, output.geometry);
+#endif
+		double renderer_milliseconds = milliseconds_since(startup_start);
+		renderer.draw_frame(); // present something (all magnitudes are 0) before waiting for the audio device
+		double first_frame_milliseconds = milliseconds_since(startup_start);
+		double audio_milliseconds = audio_startup.get();
+		std::cout << goertzel->num_reinsch_bins << " of " << num_freqs << " bins use the reinsch recurrence, kernel "
+		          << goertzel->kernel_name << '\n';
+		// linear magnitudes for each slot of the magnitude stream, encoded into magnitude_data once per analysis frame
+		// magnitude_data moves to the other slot on every commit_magnitudes, so fetch it each time
+		auto get_magnitude_data = [](av::Output const &output) -> std::span<std::byte> {
+			return std::visit([](auto const &geometry) -> std::span<std::byte> {
+				if constexpr (requires { geometry.magnitude_data; })
+					return geometry.magnitude_data;
+				return {}; // PeakBuffer
+			}, output.geometry);
+		};
+		// every window has the same layout, so the levels are encoded into each of them
+		std::vector<float> levels(
+			get_magnitude_data(renderer.outputs.front()).size() / av::magnitude_size(magnitude_format), 0.0f);
+#if !defined(PEAKS) && !defined(CHROMA)
+		auto set_level = [&](size_t i, float level) {
+#if defined(CIRCLE) || defined(BARS) || defined(SPECTROGRAM)
+			levels[i] = level;
+#elif defined(DASHBOARD)
+			for (size_t channel = 0; channel < dashboard_channels; ++channel)
+				levels[channel * num_freqs + i] = level;
+#else
+			levels[i * 2 + 2] = levels[i * 2 + 3] = level;
+#endif
+		};
+#endif
+		av::PeakDetector peak_detector{num_freqs, max_peaks};
 //		timer::stop();
 
-		rec.start();
+		std::optional<av::SoundAnalyzer> sound_analyzer;
+#if !defined(CHROMA)
+		if (detect_beats)
+#endif
+			sound_analyzer.emplace(frequencies, freqs_per_octave, static_cast<float>(analysis_fps), sound_analyzer_options);
+		std::optional<av::SpectrumPublisher> spectrum_publisher;
+		if (shared_spectrum_name)
+			spectrum_publisher.emplace(shared_spectrum_name, frequencies, sample_rate);
+		std::optional<av::NetworkSender> network_sender;
+		if (!network_destinations.empty())
+			network_sender.emplace(network_destinations, num_freqs, network_options);
+		std::optional<av::SpectrumRecorder> spectrum_recorder;
+		if (record_file_name)
+			spectrum_recorder.emplace(record_file_name, frequencies, sample_rate, recording_options);
+		unsigned recording_part = 0; // counts the files started after sample rate changes
+
+		av::realtime::report(av::realtime::configure_current_thread(analysis_thread_options), analysis_thread_options,
+		                     "analysis");
+		if (rec) rec->start();
+		std::cout << "startup: tables " << tables_milliseconds << " ms, renderer "
+		          << renderer_milliseconds - tables_milliseconds << " ms, first frame at " << first_frame_milliseconds
+		          << " ms, audio and goertzel " << audio_milliseconds << " ms in parallel, running at "
+		          << milliseconds_since(startup_start) << " ms" << std::endl;
+		renderer.print_latency_report();
+		std::cout << "uploading with the " << av::to_string(renderer.upload_strategy) << " strategy" << std::endl;
+		if (rec && switch_devices_from_console)
+			std::thread{[] {
+				for (std::string line; std::getline(std::cin, line);)
+					if (std::string *request = device_requests.begin_push()) {
+						*request = std::move(line);
+						device_requests.end_push();
+					}
+			}}.detach();
 		// relevant to normalization https://en.wikipedia.org/wiki/Parseval%27s_theorem
 		// use steady_clock to limit the fps
 		std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
 		std::chrono::steady_clock::time_point rainbow_stage_start = frame_start;
-		float max_mag = 0.0f;
+		av::Smoother smoother{num_freqs, smoothing_options};
+		std::vector<float> normalized(num_freqs, 0.0f); // what everything downstream of the analysis uses
+		std::chrono::steady_clock::time_point analysis_time = frame_start;
+		std::chrono::steady_clock::time_point next_analysis = frame_start;
+		std::chrono::steady_clock::time_point replay_start = frame_start;
+		int64_t replay_offset = replay ? replay->timestamp(0) + static_cast<int64_t>(replay_start_seconds * 1e9) : 0;
+		uint64_t frame_count = 0;
 //		size_t rainbow_offset = 0; // cycle through the colors
 		while (renderer.is_running()) {
 
 			timer::start();
+			AV_TRACE_POLL();
+			AV_TRACE_SCOPE("frame");
 
-			compute_goertzel(rec, goertzel_constants);
-			for (size_t i = 0; i < num_freqs; ++i)
-				mag[i] *= frequencies[i];
-//				mag[i] = 1.0f;
-			max_mag = std::max(max_mag * dampening_factor, *std::max_element(mag.begin(), mag.end()));
-			for (size_t i = 0; i < num_freqs; ++i) {
-//				Vertex::Color const &color = rainbow[(i + rainbow_offset) % rainbow.size()];
-//				Vertex::Color const &color = rainbow[i % rainbow.size()];
-				bool yes = (i == 0 && mag[0] > mag[1])
-				           || (i == num_freqs - 1 && mag[num_freqs - 1] > mag[num_freqs - 2])
-				           || (mag[i] > mag[i - 1] && mag[i] > mag[i + 1]);
-				if (yes || true) {
-#ifdef CIRCLE
-					vertex_data[i].color_multiplier = mag[i] / max_mag;
-#else
-					vertex_data[i * 2 + 2].color_multiplier = vertex_data[i * 2 + 3].color_multiplier =
-						mag[i] / max_mag;
-#endif
+			if (rec) rec->report_capture_thread();
+			if (std::string const *request = device_requests.front()) {
+				// only the capture device restarts, the renderer, the history and every consumer keep going
+				try {
+					rec->switch_device(request->c_str());
+					std::cout << "capturing from " << rec->get_device_name() << std::endl;
+				} catch (std::exception const &err) {
+					std::cerr << err.what() << std::endl;
+				}
+				device_requests.pop();
+				if (rec->get_sample_rate() != sample_rate && rec->get_sample_rate() > 0) { // 0 if no device works
+					sample_rate = rec->get_sample_rate();
+					goertzel.emplace(frequencies, sample_rate);
+					if (spectrum_publisher) spectrum_publisher->set_sample_rate(sample_rate);
+					if (spectrum_recorder) { // a recording has one sample rate, so the rest goes into a new file
+						spectrum_recorder.reset(); // finishes the old file
+						std::string part_file_name =
+							std::string{record_file_name} + '.' + std::to_string(++recording_part);
+						spectrum_recorder.emplace(part_file_name.c_str(), frequencies, sample_rate, recording_options);
+						std::cout << "recording continues in " << part_file_name << std::endl;
+					}
+				}
+			}
+
+			// the renderer interpolates between the last two analysis frames, so drawing doesn't wait for a new one
+			if (frame_start >= next_analysis) {
+				next_analysis = std::max(next_analysis + analysis_period, frame_start); // don't try to catch up after a stall
+				if (replay) {
+					AV_TRACE_SCOPE("replay");
+					int64_t position = replay_offset + std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - replay_start).count();
+					if (position > replay->timestamp(replay->num_frames() - 1)) { // loop
+						replay_start = std::chrono::steady_clock::now();
+						position = replay_offset;
+					}
+					replay->read(replay->frame_at(position), mag);
 				} else
-#ifdef CIRCLE
-					vertex_data[i].color_multiplier = 0.0f;
+					compute_goertzel(*rec, *goertzel);
+				{
+					AV_TRACE_SCOPE("normalize");
+					auto now = std::chrono::steady_clock::now();
+					float elapsed_seconds = std::chrono::duration<float>(now - analysis_time).count();
+					analysis_time = now;
+					if (replay)
+						std::ranges::copy(mag, normalized.begin()); // recordings are already normalized
+					else {
+						for (size_t i = 0; i < num_freqs; ++i)
+							mag[i] *= frequencies[i];
+//						mag[i] = 1.0f;
+						smoother.process(mag, elapsed_seconds, normalized);
+					}
+				}
+				if (sound_analyzer) {
+					av::SoundAnalyzer::Features const &features = sound_analyzer->analyze(normalized);
+					if (detect_beats && features.beat)
+						std::cout << "beat " << features.tempo << "bpm\n";
+				}
+				{
+					AV_TRACE_SCOPE("upload");
+#if defined(PEAKS)
+					std::span<av::Peak const> peaks = peak_detector.detect(normalized, peak_threshold);
+					for (av::Output const &output : renderer.outputs)
+						std::get<av::PeakBuffer>(output.geometry).set_peaks(peaks, 1.0f);
+#else
+#if defined(CHROMA)
+					std::ranges::copy(sound_analyzer->features.chroma, levels.begin());
 #else
-					vertex_data[i * 2 + 2].color_multiplier = vertex_data[i * 2 + 3].color_multiplier = 0.0f;
+					if (peaks_only) {
+						for (size_t i = 0; i < num_freqs; ++i)
+							set_level(i, 0.0f);
+						for (av::Peak const &peak : peak_detector.detect(normalized, peak_threshold))
+							set_level(static_cast<size_t>(std::lround(peak.bin)), peak.magnitude);
+					} else
+						for (size_t i = 0; i < num_freqs; ++i)
+							set_level(i, normalized[i]);
 #endif
+					for (av::Output const &output : renderer.outputs)
+						av::encode_magnitudes(levels, magnitude_format, get_magnitude_data(output));
+#endif
+					renderer.commit_magnitudes(analysis_time);
+				}
+				int64_t frame_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count();
+				if (spectrum_publisher) {
+					AV_TRACE_SCOPE("publish");
+					spectrum_publisher->publish(frame_timestamp, mag);
+				}
+				if (network_sender)
+					network_sender->send(frame_timestamp, normalized);
+				if (spectrum_recorder)
+					spectrum_recorder->record(frame_timestamp, normalized);
+				if (rec && rec->loudness_meter && ++frame_count % analysis_fps == 0) {
+					av::LoudnessMeter::Readings loudness = rec->loudness_meter->readings();
+					std::cout << "momentary " << loudness.momentary << " lufs short-term " << loudness.short_term
+					          << " lufs integrated " << loudness.integrated << " lufs true peak " << loudness.true_peak
+					          << " dbtp\n";
+				}
 			}
 
 //			renderer.set_vertices(vertex_vector);
 			renderer.draw_frame();
 
-			timer::stop();
+			timer::stop(renderer.gpu_nanoseconds);
 
 //			timer::fps();
+			AV_TRACE_SCOPE("wait for next frame");
 			std::chrono::steady_clock::time_point frame_end;
 			while (
 				std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -366,6 +586,11 @@ int main() {
 			}
 
 		}
+		// stop every thread that records trace events, so the dump doesn't race their writes
+		rec.reset();
+		network_sender.reset();
+		spectrum_recorder.reset();
+		AV_TRACE_DUMP(trace_file_name);
 	} catch (std::system_error &err) {
 		std::cerr << "std::system_error: code " << err.code() << ": " << err.what() << std::endl;
 		std::exit(EXIT_FAILURE);
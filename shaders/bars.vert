@@ -0,0 +1,27 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "common.glsl"
+
+layout(location = 0) in vec2 inCorner; // unit quad, shared by every bar
+layout(location = 1) in float inEncodedMagnitude; // one per bar, newest analysis frame
+layout(location = 2) in float inPreviousEncodedMagnitude; // the analysis frame before it
+
+layout(push_constant) uniform PushConstants {
+	uint numBars;
+	uint barsPerOctave;
+	float blend; // where the display time falls between the two frames
+} pushConstants;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+	float magnitude = mix(decodeMagnitude(inPreviousEncodedMagnitude), decodeMagnitude(inEncodedMagnitude), pushConstants.blend);
+	// bar i stands on the bottom edge in column i, lowest frequency on the left
+	float width = 2.0 / float(pushConstants.numBars);
+	float x = -1.0 + (float(gl_InstanceIndex) + inCorner.x) * width;
+	float y = 1.0 - 2.0 * inCorner.y * magnitude;
+	gl_Position = vec4(x, y, 0.0, 1.0);
+	uint pitchClass = uint(gl_InstanceIndex) % pushConstants.barsPerOctave;
+	fragColor = rainbow(6.0 * float(pitchClass) / float(pushConstants.barsPerOctave)) * magnitude;
+}
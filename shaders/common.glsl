@@ -0,0 +1,14 @@
+// shared by the shaders, #include "common.glsl" (GL_GOOGLE_include_directive)
+
+// MAGNITUDE_FLOOR_DB in MagnitudeEncoding.hpp, filled in by GraphicsState::create_pipeline
+layout(constant_id = 0) const float magnitudeFloorDb = -60.0;
+
+// same hue ramp as make_rainbow in main.cpp, h in [0, 6)
+vec3 rainbow(float h) {
+	return clamp(vec3(abs(h - 3.0) - 1.0, 2.0 - abs(h - 2.0), 2.0 - abs(h - 4.0)), 0.0, 1.0);
+}
+
+// inverse of encode_magnitudes in MagnitudeEncoding.cpp
+float decodeMagnitude(float encoded) {
+	return encoded > 0.0 ? pow(10.0, (encoded - 1.0) * -magnitudeFloorDb / 10.0) : 0.0;
+}
@@ -0,0 +1,37 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "common.glsl"
+
+layout(location = 0) in vec4 inViewport; // per channel, x y width height in normalized device coordinates
+
+// every channel's encoded magnitudes, channel after channel, for each slot of the ring (see MagnitudeSlots.hpp)
+layout(set = 0, binding = 0) uniform samplerBuffer encodedMagnitudes;
+
+layout(push_constant) uniform PushConstants {
+	uint numBars; // per channel
+	uint barsPerOctave;
+	uint newestOffset; // where each frame starts in encodedMagnitudes
+	uint previousOffset;
+	float blend; // where the display time falls between the two frames
+} pushConstants;
+
+layout(location = 0) out vec3 fragColor;
+
+// two triangles per bar
+const vec2 corners[6] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0));
+
+void main() {
+	uint bar = uint(gl_VertexIndex) / 6u;
+	vec2 corner = corners[uint(gl_VertexIndex) % 6u];
+	int index = int(uint(gl_InstanceIndex) * pushConstants.numBars + bar);
+	float magnitude = mix(
+		decodeMagnitude(texelFetch(encodedMagnitudes, int(pushConstants.previousOffset) + index).r),
+		decodeMagnitude(texelFetch(encodedMagnitudes, int(pushConstants.newestOffset) + index).r),
+		pushConstants.blend);
+	// same as bars.vert inside the channel's cell, bar i stands on the bottom edge in column i
+	vec2 position = vec2((float(bar) + corner.x) / float(pushConstants.numBars), 1.0 - corner.y * magnitude);
+	gl_Position = vec4(inViewport.xy + position * inViewport.zw, 0.0, 1.0);
+	uint pitchClass = bar % pushConstants.barsPerOctave;
+	fragColor = rainbow(6.0 * float(pitchClass) / float(pushConstants.barsPerOctave)) * magnitude;
+}
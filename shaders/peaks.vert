@@ -0,0 +1,28 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "common.glsl"
+
+layout(location = 0) in vec2 inCorner; // unit quad, shared by every peak
+layout(location = 1) in float inBin; // fractional bin from PeakDetector
+layout(location = 2) in float inMagnitude; // linear, already normalized
+
+layout(push_constant) uniform PushConstants {
+	uint numBins;
+	uint binsPerOctave;
+} pushConstants;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+	// same columns as bars.vert, but each peak is a thin line centered on its interpolated bin
+	const float lineWidth = 0.25; // in bins
+	float magnitude = min(inMagnitude, 1.0);
+	float column = inBin + 0.5 + (inCorner.x - 0.5) * lineWidth;
+	float x = -1.0 + 2.0 * column / float(pushConstants.numBins);
+	float y = 1.0 - 2.0 * inCorner.y * magnitude;
+	gl_Position = vec4(x, y, 0.0, 1.0);
+	// the hue moves continuously with the sub-bin position
+	float pitchClass = mod(inBin, float(pushConstants.binsPerOctave));
+	fragColor = rainbow(6.0 * pitchClass / float(pushConstants.binsPerOctave)) * magnitude;
+}
@@ -1,12 +1,20 @@
-#version 410
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "common.glsl"
 
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
-layout(location = 2) in float colorMultiplier;
+layout(location = 2) in float inMagnitude; // encoded, from its own vertex stream, newest analysis frame
+layout(location = 3) in float inPreviousMagnitude; // the analysis frame before it
+
+layout(push_constant) uniform PushConstants {
+	float blend; // where the display time falls between the two frames
+} pushConstants;
 
 layout(location = 0) out vec3 fragColor;
 
 void main() {
 	gl_Position = vec4(inPosition, 0.0, 1.0);
-	fragColor = inColor * colorMultiplier;
+	fragColor = inColor * mix(decodeMagnitude(inPreviousMagnitude), decodeMagnitude(inMagnitude), pushConstants.blend);
 }
@@ -0,0 +1,27 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "common.glsl"
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec4 outColor;
+
+// ring of magnitude rows, x = frequency bin, y = analysis frame
+layout(set = 0, binding = 0) uniform sampler2D history;
+
+layout(push_constant) uniform PushConstants {
+	uint numBins;
+	uint binsPerOctave;
+	uint numRows;
+	uint head; // one past the newest row
+} pushConstants;
+
+void main() {
+	// lowest frequency on the left, newest row at the top
+	uint bin = min(uint(uv.x * float(pushConstants.numBins)), pushConstants.numBins - 1u);
+	uint rowsAgo = min(uint(uv.y * float(pushConstants.numRows)), pushConstants.numRows - 1u);
+	uint row = (pushConstants.head + pushConstants.numRows - 1u - rowsAgo) % pushConstants.numRows;
+	float magnitude = decodeMagnitude(texelFetch(history, ivec2(bin, row), 0).r);
+	uint pitchClass = bin % pushConstants.binsPerOctave;
+	outColor = vec4(rainbow(6.0 * float(pitchClass) / float(pushConstants.binsPerOctave)) * magnitude, 1.0);
+}
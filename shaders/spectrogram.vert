@@ -0,0 +1,9 @@
+#version 450
+
+layout(location = 0) out vec2 uv;
+
+// fullscreen triangle without a vertex buffer, see SpectrogramImage::bind_and_draw
+void main() {
+	uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}